@@ -27,10 +27,14 @@ namespace Game3 {
 			Texture & operator=(const Texture &) = default;
 			Texture & operator=(Texture &&) = default;
 
+			/** Loads the image and uploads it to the GPU. In headless mode, only the image's dimensions are read. */
 			void init();
 			void bind(int bind_id = -1);
 			bool valid() const { return *valid_; }
 
+			/** Set by headless games, which have no OpenGL context to upload textures to. */
+			static bool headless;
+
 			static std::string filterToString(int);
 			static int stringToFilter(const std::string &);
 
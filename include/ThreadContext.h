@@ -1,14 +1,18 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <random>
 #include <thread>
+#include <vector>
 
 #include "Types.h"
 
 namespace Game3 {
 	class Game;
+	class ObjectPool;
+	class Realm;
 
 	class ThreadContext {
 		public:
@@ -19,6 +23,14 @@ namespace Game3 {
 			Index colMin = -1;
 			Index colMax = -1;
 			bool valid = false;
+			/** Set while this thread ticks a region of a realm in parallel with other threads. Realm mutations made
+			 *  during that time are appended here and applied once every region has been ticked. */
+			std::vector<std::function<void()>> *commandBuffer = nullptr;
+			/** Set while this thread ticks a whole realm in parallel with other realms. Changes to this realm happen right
+			 *  away; changes to any other realm go to commandBuffer. */
+			const Realm *exclusiveRealm = nullptr;
+			/** Where makePooled allocates on this thread. Set by ObjectPool::Scope; null means the default pool. */
+			ObjectPool *objectPool = nullptr;
 
 			ThreadContext():
 				rng(std::chrono::system_clock::now().time_since_epoch().count()),
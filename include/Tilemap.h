@@ -10,6 +10,7 @@
 #include "Position.h"
 #include "Texture.h"
 #include "Types.h"
+#include "container/TileChunk.h"
 
 namespace Game3 {
 	class Quadtree;
@@ -17,9 +18,47 @@ namespace Game3 {
 
 	class Tilemap {
 		private:
-			std::vector<TileID> tiles;
+			/** Row-major grid of chunks. */
+			std::vector<TileChunk> chunks;
+			Index chunksWide = 0;
+			Index chunksHigh = 0;
+			TileLayout layout = DEFAULT_LAYOUT;
+			const TileChunk::Spread *spread = &TileChunk::getSpread(DEFAULT_LAYOUT);
+
+			/** Returns the index of a tile within its chunk. */
+			inline size_t getChunkIndex(Index x, Index y) const {
+				return spread->x[x & TileChunk::MASK] | spread->y[y & TileChunk::MASK];
+			}
+
+			inline const TileChunk & getChunk(Index x, Index y) const {
+				return chunks[(x >> TileChunk::SHIFT) + (y >> TileChunk::SHIFT) * chunksWide];
+			}
+
+			inline TileChunk & getChunk(Index x, Index y) {
+				return chunks[(x >> TileChunk::SHIFT) + (y >> TileChunk::SHIFT) * chunksWide];
+			}
+
+			void initChunks();
+			/** Returns the indices of the chunks in a region in row-major order, leaving out any that lie past the edges of the map. */
+			std::vector<size_t> getRegionChunks(Index region_x, Index region_y) const;
+			/** Returns the uncompressed serialized form of a region. */
+			std::vector<uint8_t> encodeRegion(Index region_x, Index region_y) const;
+			/** Loads a region from its uncompressed serialized form. Packed words in the buffer are used in place
+			 *  (after being byte-swapped in place on big-endian hosts). */
+			void decodeRegion(Index region_x, Index region_y, const std::shared_ptr<uint64_t[]> &, size_t size);
+
+			static inline size_t alignBlob(size_t offset) { return (offset + 7) & ~size_t(7); }
 
 		public:
+			/** The width and height (in chunks) of the regions that are compressed independently when saving. */
+			constexpr static Index REGION_CHUNKS = 4;
+			constexpr static int DEFAULT_COMPRESSION_LEVEL = 19;
+			/** For saves that happen often, where writing quickly matters more than the size of the file. */
+			constexpr static int FAST_COMPRESSION_LEVEL = 1;
+			/** Storing regions uncompressed lets them be used directly from a memory-mapped save. */
+			constexpr static int UNCOMPRESSED = 0;
+			constexpr static TileLayout DEFAULT_LAYOUT = TileLayout::Morton;
+
 			int width = 0;
 			int height = 0;
 			int tileSize = 0;
@@ -40,29 +79,76 @@ namespace Game3 {
 			std::vector<Index> getLand(Index right_pad = 0, Index bottom_pad = 0) const;
 			std::shared_ptr<Texture> getTexture(const Game &);
 
-			inline const decltype(tiles)::value_type & operator()(Index x, Index y) const {
-				return tiles[x + y * width];
+			inline TileID operator()(Index x, Index y) const {
+				return getChunk(x, y)[getChunkIndex(x, y)];
 			}
 
-			inline const decltype(tiles)::value_type & operator[](const Position &position) const {
-				return tiles[position.column + position.row * width];
+			inline TileID operator[](const Position &position) const {
+				return (*this)(position.column, position.row);
 			}
 
-			inline const decltype(tiles)::value_type & operator[](Index index) const {
-				return tiles[index];
+			inline TileID operator[](Index index) const {
+				return (*this)(index % width, index / width);
 			}
 
 			void set(Index x, Index y, TileID);
 			void set(const Position &, TileID);
 			void set(Index, TileID);
+			/** Doesn't update the lava quadtree. Multiple threads can call this at once as long as they write to different chunks. */
+			void setUnsafe(Index, TileID);
+			/** Brings the lava quadtree up to date for indices that were written with setUnsafe. Rebuilds the whole quadtree
+			 *  instead if a large part of the map was written. */
+			void updateLava(const std::vector<Index> &);
+
+			/** Calls the visitor with the row offset, column offset and tile of each neighbor of (x, y) that lies within the map,
+			 *  going through the offsets in row-major order. Neighbors must be 4 (orthogonal) or 8 (orthogonal and diagonal).
+			 *  Tiles whose neighbors are all in the same chunk are read without bounds checks or chunk lookups. */
+			template <int Neighbors = 8, typename F>
+			void iterateNeighbors(Index x, Index y, F &&visitor) const {
+				static_assert(Neighbors == 4 || Neighbors == 8);
+				const Index local_x = x & TileChunk::MASK;
+				const Index local_y = y & TileChunk::MASK;
+
+				if (0 < local_x && local_x < TileChunk::MASK && 0 < local_y && local_y < TileChunk::MASK && x + 1 < width && y + 1 < height) {
+					const TileChunk &chunk = getChunk(x, y);
+					for (Index row_offset = -1; row_offset <= 1; ++row_offset)
+						for (Index column_offset = -1; column_offset <= 1; ++column_offset)
+							if ((row_offset != 0 || column_offset != 0) && (Neighbors == 8 || row_offset == 0 || column_offset == 0))
+								visitor(row_offset, column_offset, chunk[spread->x[local_x + column_offset] | spread->y[local_y + row_offset]]);
+					return;
+				}
+
+				for (Index row_offset = -1; row_offset <= 1; ++row_offset)
+					for (Index column_offset = -1; column_offset <= 1; ++column_offset)
+						if ((row_offset != 0 || column_offset != 0) && (Neighbors == 8 || row_offset == 0 || column_offset == 0)) {
+							const Index neighbor_x = x + column_offset;
+							const Index neighbor_y = y + row_offset;
+							if (0 <= neighbor_x && neighbor_x < width && 0 <= neighbor_y && neighbor_y < height)
+								visitor(row_offset, column_offset, (*this)(neighbor_x, neighbor_y));
+						}
+			}
 
-			void reset(TileID = 0);
-
-			inline const auto & getTiles() { return tiles; }
-			inline auto & getTilesUnsafe() { return tiles; }
-			inline size_t size() const { return tiles.size(); }
-			inline const TileID * data() const { return tiles.data(); }
+			inline TileLayout getLayout() const { return layout; }
+			/** Reorders the tiles within every chunk to match a different layout. */
+			void setLayout(TileLayout);
 
+			void reset(TileID = 0);
+			/** Collapses chunks whose tiles have all become the same back into single values. */
+			void compact();
+
+			/** Returns a row-major copy of all the tiles. */
+			std::vector<TileID> getTiles() const;
+			/** Replaces all the tiles with the contents of a row-major vector. Doesn't update the lava quadtree. */
+			void setTiles(const std::vector<TileID> &);
+			inline size_t size() const { return static_cast<size_t>(width) * height; }
+
+			/** Serializes the tilemap in an endian-independent binary format, compressing regions in parallel with the given zstd level. */
+			std::vector<uint8_t> toBlob(int compression_level = DEFAULT_COMPRESSION_LEVEL) const;
+			/** If an owner is given, uncompressed regions in the data are used in place instead of being copied and keep the owner alive.
+			 *  Such data must be writable (e.g. a private mapping), as chunks that end up sole owners of their words write to them directly. */
+			static Tilemap fromBlob(const Game &, const uint8_t *data, size_t size, const std::shared_ptr<void> &owner = nullptr);
+			/** Stores a blob as a binary value. */
+			void toJSON(nlohmann::json &, int compression_level = DEFAULT_COMPRESSION_LEVEL) const;
 			static Tilemap fromJSON(const Game &, const nlohmann::json &);
 
 		private:
@@ -3,6 +3,7 @@
 #include <map>
 #include <memory>
 #include <set>
+#include <vector>
 
 #include "Types.h"
 #include "registry/Registerable.h"
@@ -12,14 +13,37 @@ namespace Game3 {
 	class ItemStack;
 	class Texture;
 
+	/** The tiles in a tileset category, stored both as a bitset indexed by TileID and as a sorted list. */
+	class TileCategory {
+		public:
+			Identifier name;
+			bool marchable = false;
+
+			inline bool contains(TileID id) const {
+				const size_t word = id / 64;
+				return word < bits.size() && ((bits[word] >> (id % 64)) & 1) != 0;
+			}
+
+			/** Returns the IDs of the tiles in the category in ascending order. */
+			inline const std::vector<TileID> & getIDs() const { return ids; }
+
+		private:
+			std::vector<uint64_t> bits;
+			std::vector<TileID> ids;
+
+		friend class Tileset;
+	};
+
+	using TileCategoryPtr = std::shared_ptr<const TileCategory>;
+
 	class Tileset: public NamedRegisterable {
 		public:
 			bool isLand(const Identifier &) const;
-			bool isLand(TileID) const;
+			inline bool isLand(TileID id) const { return getFlags(id) & LAND; }
 			bool isWalkable(const Identifier &) const;
-			bool isWalkable(TileID) const;
+			inline bool isWalkable(TileID id) const { return getFlags(id) & WALKABLE; }
 			bool isSolid(const Identifier &) const;
-			bool isSolid(TileID) const;
+			inline bool isSolid(TileID id) const { return getFlags(id) & SOLID; }
 			const Identifier & getEmpty() const;
 			TileID getEmptyID() const;
 			const Identifier & getMissing() const;
@@ -29,13 +53,19 @@ namespace Game3 {
 			std::shared_ptr<Texture> getTexture(const Game &);
 			const Identifier & getTextureName() const { return textureName; }
 			bool getItemStack(Game &, const Identifier &, ItemStack &) const;
-			bool isMarchable(TileID);
+			/** Whether the tile or any of its categories is marchable. */
+			inline bool isMarchable(TileID id) const { return getFlags(id) & MARCHABLE; }
 			bool isCategoryMarchable(const Identifier &category) const;
 			void clearCache();
-			const std::set<Identifier> getCategories(const Identifier &) const;
-			const std::set<TileID> getCategoryIDs(const Identifier &) const;
-			const std::set<Identifier> getTilesByCategory(const Identifier &) const;
+			const std::set<Identifier> & getCategories(const Identifier &) const;
+			/** Returns the categories a tile belongs to without allocating. */
+			const std::vector<TileCategoryPtr> & getCategories(TileID) const;
+			const TileCategory & getCategory(const Identifier &) const;
+			/** Returns the IDs of the tiles in a category in ascending order. */
+			const std::vector<TileID> & getCategoryIDs(const Identifier &) const;
+			const std::set<Identifier> & getTilesByCategory(const Identifier &) const;
 			bool isInCategory(const Identifier &tilename, const Identifier &category) const;
+			bool isInCategory(TileID, const Identifier &category) const;
 			bool hasName(const Identifier &) const;
 			bool hasCategory(const Identifier &) const;
 			const TileID & operator[](const Identifier &) const;
@@ -44,6 +74,13 @@ namespace Game3 {
 			static Tileset fromJSON(Identifier, const nlohmann::json &);
 
 		private:
+			enum Flags: uint8_t {
+				LAND      = 1 << 0,
+				WALKABLE  = 1 << 1,
+				SOLID     = 1 << 2,
+				MARCHABLE = 1 << 3,
+			};
+
 			Tileset(Identifier identifier_);
 			std::string name;
 			Identifier empty;
@@ -63,9 +100,16 @@ namespace Game3 {
 			std::map<Identifier, std::set<Identifier>> categories;
 			/** Maps tile names to sets of category names. */
 			std::map<Identifier, std::set<Identifier>> inverseCategories;
-			std::set<TileID> marchableCache;
-			std::set<TileID> unmarchableCache;
+			/** Indexed by TileID and filled in by fromJSON. */
+			std::vector<uint8_t> tileFlags;
+			/** Indexed by TileID. */
+			std::vector<std::vector<TileCategoryPtr>> tileCategories;
+			std::map<Identifier, TileCategoryPtr> categoryTables;
 			std::optional<std::vector<TileID>> brightCache;
+
+			/** Throws std::out_of_range for IDs past the end of the tileset, like looking up their names would. */
+			inline uint8_t getFlags(TileID id) const { return tileFlags.at(id); }
+			void buildTables();
 	};
 
 	using TilesetPtr = std::shared_ptr<Tileset>;
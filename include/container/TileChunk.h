@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "Types.h"
+
+namespace Game3 {
+	/** The order in which the tiles of a chunk are stored. In Morton (Z-order) layout, the bits of the column and row are
+	 *  interleaved, so tiles that are close together vertically are usually close together in memory as well. */
+	enum class TileLayout: uint8_t {RowMajor = 0, Morton = 1};
+
+	/** A square block of tiles. A chunk in which every tile is the same is stored as a single value
+	 *  until something different is written to it. Otherwise, the chunk keeps a palette of the tile IDs
+	 *  it contains and stores each tile as a 1-, 2-, 4- or 8-bit index into it, widening the indices when
+	 *  the palette outgrows them. Chunks with more than 256 distinct IDs store raw 16-bit IDs instead.
+	 *  Copies share their packed storage until one of them is written to. */
+	class TileChunk {
+		public:
+			constexpr static Index SHIFT = 5;
+			constexpr static Index SIZE  = Index(1) << SHIFT;
+			constexpr static Index MASK  = SIZE - 1;
+			constexpr static Index AREA  = SIZE * SIZE;
+			constexpr static uint8_t RAW_BITS = 16;
+
+			/** Lookup tables for a layout: the index of the tile at chunk-relative coordinates (x, y) is x[x] | y[y]. */
+			struct Spread {
+				std::array<uint16_t, SIZE> x;
+				std::array<uint16_t, SIZE> y;
+			};
+
+			TileChunk(TileID fill_value = 0):
+				uniformValue(fill_value) {}
+
+			static const Spread & getSpread(TileLayout);
+			/** Returns the number of 64-bit words needed to store a chunk at a given bit width. */
+			static inline size_t getWordCount(uint8_t bits) { return static_cast<size_t>(AREA) * bits / 64; }
+
+			inline TileID operator[](size_t index) const {
+				if (bits == 0)
+					return uniformValue;
+				const size_t bit = index * bits;
+				const auto packed = static_cast<TileID>((words[bit / 64] >> (bit % 64)) & ((uint64_t(1) << bits) - 1));
+				return bits == RAW_BITS? packed : palette[packed];
+			}
+
+			void set(size_t index, TileID);
+			void fill(TileID);
+			/** Replaces the contents of the chunk with AREA tiles in chunk order, choosing the narrowest representation that fits them. */
+			void assign(const TileID *);
+			/** Takes over packed storage produced elsewhere, e.g. by deserialization. The words may be shared with other chunks. */
+			void adopt(uint8_t bits_, std::vector<TileID> palette_, std::shared_ptr<uint64_t[]> words_);
+			/** Writes all AREA tiles to the given buffer in chunk order. */
+			void copyTo(TileID *) const;
+			/** Rebuilds the palette from the tiles actually present and narrows the indices if possible.
+			 *  Returns true if the chunk ended up storing a single value. */
+			bool compact();
+
+			inline bool isUniform() const { return bits == 0; }
+			/** Only meaningful if isUniform() returns true. */
+			inline TileID getUniformValue() const { return uniformValue; }
+			inline uint8_t getBits() const { return bits; }
+			inline const auto & getPalette() const { return palette; }
+			/** Returns nullptr if the chunk is uniform. Contains getWordCount(getBits()) words otherwise. */
+			inline const uint64_t * getWords() const { return words.get(); }
+
+		private:
+			TileID uniformValue = 0;
+			/** 0 if the chunk is uniform, RAW_BITS if the palette isn't in use, or else the width of each palette index. */
+			uint8_t bits = 0;
+			std::vector<TileID> palette;
+			std::shared_ptr<uint64_t[]> words;
+
+			void write(size_t index, uint64_t packed);
+			/** Re-encodes the chunk with a different index width. */
+			void repack(uint8_t new_bits);
+			/** Makes sure the chunk has packed storage of its own that can be written to. */
+			void unshare();
+	};
+}
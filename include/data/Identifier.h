@@ -1,37 +1,46 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
 #include <nlohmann/json.hpp>
 
 namespace Game3 {
+	/** A namespaced name like "base:item/iron_bar". Every distinct identifier is interned in a global table once and
+	 *  represented by an integer handle, so copying, comparing for equality and hashing don't touch the strings. */
 	struct Identifier {
-		std::string space;
-		std::string name;
+		using Handle = uint32_t;
 
 		Identifier() = default;
-		Identifier(const char *space_, const char *name_): space(space_), name(name_) {}
+		Identifier(std::string_view space_, std::string_view name_);
 		Identifier(std::string_view);
 		Identifier(const char *);
+		Identifier(const std::string &);
 
 		inline explicit operator bool() const {
-			if (space.empty() != name.empty())
+			if (handle == 0)
+				return false;
+			if (getSpace().empty() != getName().empty())
 				throw std::runtime_error("Partially empty identifier");
-			return !space.empty();
+			return !getSpace().empty();
 		}
 
 		inline explicit operator std::string() const {
-			return space + ':' + name;
+			return str();
 		}
 
-		inline std::string str() const {
-			return static_cast<std::string>(*this);
-		}
+		/** Returns the full "space:name" form. */
+		const std::string & str() const;
+		const std::string & getSpace() const;
+		const std::string & getName() const;
+		inline Handle getHandle() const { return handle; }
 
 		inline bool inSpace(std::string_view check) const {
-			return std::string_view(space) == check;
+			return std::string_view(getSpace()) == check;
 		}
 
 		/** Returns "foo/bar" for "base:foo/bar/baz". */
@@ -43,16 +52,38 @@ namespace Game3 {
 		/** Returns "baz" for "base:foo/bar/baz". */
 		std::string getPostPath() const;
 
-		auto operator<=>(const Identifier &) const = default;
+		/** Orders identifiers by their space and then their name, like comparing the strings would. */
+		std::strong_ordering operator<=>(const Identifier &) const;
 
 		bool operator==(std::string_view) const;
-		bool operator==(const Identifier &) const;
+		inline bool operator==(const Identifier &other) const { return handle == other.handle; }
+
+		private:
+			/** 0 is the empty identifier. */
+			Handle handle = 0;
+	};
+
+	/** Lets string literals be used as template arguments. */
+	template <size_t N>
+	struct IdentifierLiteral {
+		char data[N];
+
+		constexpr IdentifierLiteral(const char (&string)[N]) {
+			std::copy_n(string, N, data);
+		}
+
+		constexpr std::string_view view() const { return {data, N - 1}; }
 	};
 
 	void from_json(const nlohmann::json &, Identifier &);
 	void to_json(nlohmann::json &, const Identifier &);
 
-	Identifier operator""_id(const char *string, size_t);
+	/** Each distinct literal is interned the first time it's evaluated and cached after that. */
+	template <IdentifierLiteral L>
+	Identifier operator""_id() {
+		static const Identifier cached(L.view());
+		return cached;
+	}
 }
 
 std::ostream & operator<<(std::ostream &, const Game3::Identifier &);
@@ -61,7 +92,7 @@ namespace std {
 	template <>
 	struct hash<Game3::Identifier> {
 		size_t operator()(const Game3::Identifier &identifier) const {
-			return std::hash<std::string>()(static_cast<std::string>(identifier));
+			return std::hash<Game3::Identifier::Handle>()(identifier.getHandle());
 		}
 	};
 }
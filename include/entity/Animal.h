@@ -12,6 +12,8 @@ namespace Game3 {
 			static Identifier ID() { return {"base", "entity/animal"}; }
 			constexpr static HitPoints MAX_HEALTH = 20;
 			constexpr static float RETRY_TIME = 30.f;
+			/** How many random targets wander() tries before giving up until the next wander. */
+			constexpr static int WANDER_ATTEMPTS = 4;
 
 			static inline auto getWanderDistribution() {
 				return std::uniform_real_distribution(10.f, 20.f);
@@ -24,6 +26,7 @@ namespace Game3 {
 			void toJSON(nlohmann::json &) const override;
 			void absorbJSON(Game &, const nlohmann::json &) override;
 			virtual void tick(Game &, float) override;
+			void catchUp(Game &, float delta) override;
 			float getSpeed() const override { return 5.f; }
 			bool wander();
 
@@ -31,6 +31,7 @@ namespace Game3 {
 			Blacksmith(RealmID overworld_realm, RealmID house_realm, Position house_position, std::shared_ptr<Building> keep_);
 
 			void interact(const Position &);
+			Phase getRestingPhase() const override { return 12; }
 
 		private:
 			ItemCount coalNeeded = 0;
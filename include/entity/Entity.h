@@ -17,11 +17,13 @@
 #include "game/Agent.h"
 #include "game/HasInventory.h"
 #include "item/Item.h"
+#include "util/ObjectPool.h"
 
 namespace Game3 {
 	class Canvas;
 	class Game;
 	class Inventory;
+	class MovementSystem;
 	class Player;
 	class Realm;
 	class SpriteRenderer;
@@ -43,11 +45,6 @@ namespace Game3 {
 			RealmID realmID = 0;
 			std::weak_ptr<Realm> weakRealm;
 			Direction direction = Direction::Down;
-			/** When the entity moves a square, its position field is immediately updated but this field is set to an offset
-			 *  such that the sum of the new position and the offset is equal to the old offset. The offset is moved closer
-			 *  to zero each tick to achieve smooth movement instead of teleportation from one tile to the next. */
-			Eigen::Vector2f offset {0.f, 0.f};
-			std::list<Direction> path;
 			MoneyCount money = 0;
 			HitPoints health = 0;
 
@@ -56,7 +53,7 @@ namespace Game3 {
 			/** This won't call init() on the Entity. You need to do that yourself. */
 			template <typename T = Entity, typename... Args>
 			static std::shared_ptr<T> create(Args && ...args) {
-				auto out = std::shared_ptr<T>(new T(std::forward<Args>(args)...));
+				auto out = makePooled<T>([&](void *storage) { return new (storage) T(std::forward<Args>(args)...); });
 				out->health = out->maxHealth();
 				return out;
 			}
@@ -71,6 +68,11 @@ namespace Game3 {
 			bool isInvincible() const { return maxHealth() == 0; }
 			virtual void render(SpriteRenderer &);
 			virtual void tick(Game &, float delta);
+			/** Advances the entity by a long stretch of time in one step, for realms that have been ticking at a reduced rate.
+			 *  The default follows as much of the entity's path as it could have walked in that time. */
+			virtual void catchUp(Game &, float delta);
+			/** Whether the entity is in the middle of something that needs its realm to be ticked at the full rate. */
+			virtual bool isBusy() const { return false; }
 			/** Removes the entity from existence. */
 			virtual void remove();
 			/** Handles when the player interacts with the tile they're on and that tile contains this entity. Returns whether anything interesting happened. */
@@ -99,7 +101,23 @@ namespace Game3 {
 			void queueForMove(const std::function<bool(const std::shared_ptr<Entity> &)> &);
 			bool pathfind(const Position &start, const Position &goal, std::list<Direction> &);
 			bool pathfind(const Position &goal);
+			/** The steps the entity still has to take. The realm's MovementSystem takes the next one as soon as the
+			 *  entity's offset along that step's axis has eased to zero. */
+			inline const std::list<Direction> & getPath() const { return path; }
+			inline bool hasPath() const { return !path.empty(); }
+			void setPath(std::list<Direction>);
+			void clearPath();
+			/** Subclasses whose speed can change have to call onSpeedChanged() when it does. */
 			virtual float getSpeed() const { return MAX_SPEED; }
+			/** When the entity moves a square, its position field is immediately updated but its offset is set such that
+			 *  the sum of the new position and the offset is equal to the old position. The realm's MovementSystem moves the
+			 *  offset closer to zero each tick to achieve smooth movement instead of teleportation from one tile to the next.
+			 *  The offset is always zero while the entity isn't in a realm. */
+			Eigen::Vector2f getOffset() const;
+			void setOffset(const Eigen::Vector2f &);
+			/** Returns the offset moved toward zero by however much of the next tick has already elapsed, so that movement
+			 *  looks smooth when frames are drawn more often than ticks happen. */
+			Eigen::Vector2f getRenderOffset() const;
 			virtual Glib::ustring getName() { return "Unknown Entity (" + std::string(type) + ')'; }
 			Game & getGame();
 			const Game & getGame() const;
@@ -113,10 +131,27 @@ namespace Game3 {
 			Entity() = delete;
 			Entity(EntityType);
 
+			/** Returns what the offset will be after the given number of seconds of movement. */
+			Eigen::Vector2f advanceOffset(float seconds) const;
+
 			bool canMoveTo(const Position &) const;
+			/** Tells the realm's MovementSystem, which keeps its own copy of the speed, that getSpeed() changed. */
+			void onSpeedChanged();
 			/** A list of functions to call the next time the entity moves. The functions return whether they should be removed from the queue. */
 			std::list<std::function<bool(const std::shared_ptr<Entity> &)>> moveQueue;
 			std::shared_ptr<Texture> getTexture();
+
+		private:
+			MovementSystem *movementSystem = nullptr;
+			size_t movementSlot = 0;
+			std::list<Direction> path;
+
+			/** Takes the next step of the path if it can. Called by the MovementSystem. */
+			void followPath();
+			/** Tells the realm's MovementSystem, which tracks which entities have a step to take, that the path changed. */
+			void onPathChanged();
+
+			friend class MovementSystem;
 	};
 
 	void to_json(nlohmann::json &, const Entity &);
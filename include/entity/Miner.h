@@ -33,6 +33,7 @@ namespace Game3 {
 			Miner(RealmID overworld_realm, RealmID house_realm, const Position &house_position, const std::shared_ptr<Building> &keep_);
 
 			void interact(const Position &);
+			Phase getRestingPhase() const override { return 11; }
 
 		private:
 			void wakeUp();
@@ -16,7 +16,6 @@ namespace Game3 {
 
 			std::unordered_set<Identifier> stationTypes {{}};
 
-			float speed = 10.f;
 			bool movingUp = false;
 			bool movingRight = false;
 			bool movingDown = false;
@@ -41,6 +40,7 @@ namespace Game3 {
 			void teleport(const Position &, const std::shared_ptr<Realm> &) override;
 			void addMoney(MoneyCount);
 			float getSpeed() const override { return speed; }
+			void setSpeed(float);
 			bool setTooldown(float multiplier);
 			inline bool hasTooldown() const { return 0.f < tooldown; }
 			void showText(const Glib::ustring &text, const Glib::ustring &name);
@@ -54,6 +54,9 @@ namespace Game3 {
 		protected:
 			Player();
 			void interact(const Position &);
+
+		private:
+			float speed = 10.f;
 	};
 
 	void to_json(nlohmann::json &, const Player &);
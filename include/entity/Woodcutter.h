@@ -32,6 +32,7 @@ namespace Game3 {
 			Woodcutter(RealmID overworld_realm, RealmID house_realm, Position house_position, std::shared_ptr<Building> keep_);
 
 			void interact(const Position &);
+			Phase getRestingPhase() const override { return 11; }
 
 		private:
 			void wakeUp();
@@ -26,6 +26,10 @@ namespace Game3 {
 			void toJSON(nlohmann::json &) const override;
 			void absorbJSON(Game &, const nlohmann::json &) override;
 			void initAfterLoad(Game &) override;
+			/** Workers that are awake and not waiting in bed need their realm to tick at the full rate. */
+			bool isBusy() const override;
+			/** Only called while the worker isn't busy, when all that its tick does is check the time. */
+			void catchUp(Game &game, float delta) override { tick(game, delta); }
 
 			friend class Entity;
 
@@ -36,6 +40,8 @@ namespace Game3 {
 			Worker(EntityType, RealmID overworld_realm, RealmID house_realm, Position house_position, std::shared_ptr<Building> keep_);
 
 			HitPoints maxHealth() const override { return MAX_HEALTH; }
+			/** The phase the worker is in once it's in bed for the night. */
+			virtual Phase getRestingPhase() const = 0;
 			bool stillStuck(float delta);
 			void goToKeep(Phase new_phase);
 			void goToStockpile(Phase new_phase);
@@ -10,42 +10,64 @@
 #include "Position.h"
 #include "Texture.h"
 #include "Types.h"
+#include "container/TileChunk.h"
+#include "util/Util.h"
 
 namespace Game3 {
 	struct BiomeMap {
 		int width = 0;
 		int height = 0;
+		/** In row-major layout, the tiles form a single row-major grid. In Morton layout, the map is divided into
+		 *  TileChunk::SIZE-square blocks stored one after another in row-major order, each with its tiles in Morton order. */
+		TileLayout layout = TileLayout::RowMajor;
+		/** Use getIndex to find a tile's position in here. */
 		std::vector<BiomeType> tiles;
 
 		BiomeMap() = default;
 
-		BiomeMap(int width_, int height_): width(width_), height(height_) {
-			tiles.resize(width * height);
-		}
-
-		BiomeMap(int width_, int height_, BiomeType fill): width(width_), height(height_) {
-			tiles.resize(width * height, fill);
+		BiomeMap(int width_, int height_, BiomeType fill = 0, TileLayout layout_ = TileLayout::Morton):
+		width(width_), height(height_), layout(layout_) {
+			tiles.resize(getStorageSize(), fill);
 		}
 
 		inline void fill(BiomeType value) {
 			tiles.assign(tiles.size(), value);
 		}
 
-		inline decltype(tiles)::value_type & operator()(int x, int y) {
-			return tiles[x + y * width];
+		inline size_t getIndex(Index x, Index y) const {
+			if (layout == TileLayout::RowMajor)
+				return x + y * width;
+			const auto &spread = getMortonSpread();
+			const Index block = (x >> TileChunk::SHIFT) + (y >> TileChunk::SHIFT) * updiv<Index>(width, TileChunk::SIZE);
+			return block * TileChunk::AREA + (spread.x[x & TileChunk::MASK] | spread.y[y & TileChunk::MASK]);
+		}
+
+		/** Returns the number of tiles stored for the map, including padding at the edges in Morton layout. */
+		size_t getStorageSize() const;
+		/** Moves the tiles around to match a different layout. */
+		void setLayout(TileLayout);
+
+		inline decltype(tiles)::value_type & operator()(Index x, Index y) {
+			return tiles[getIndex(x, y)];
 		}
 
-		inline const decltype(tiles)::value_type & operator()(int x, int y) const {
-			return tiles[x + y * width];
+		inline const decltype(tiles)::value_type & operator()(Index x, Index y) const {
+			return tiles[getIndex(x, y)];
 		}
 
 		inline decltype(tiles)::value_type & operator()(const Position &position) {
-			return tiles[position.column + position.row * width];
+			return tiles[getIndex(position.column, position.row)];
 		}
 
 		inline const decltype(tiles)::value_type & operator()(const Position &position) const {
-			return tiles[position.column + position.row * width];
+			return tiles[getIndex(position.column, position.row)];
 		}
+
+		private:
+			static const TileChunk::Spread & getMortonSpread() {
+				static const auto &spread = TileChunk::getSpread(TileLayout::Morton);
+				return spread;
+			}
 	};
 
 	void to_json(nlohmann::json &, const BiomeMap &);
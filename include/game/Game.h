@@ -20,24 +20,44 @@
 namespace Game3 {
 	class Canvas;
 	class MainWindow;
+	class MappedFile;
 	class Menu;
 	class Player;
+	class ThreadPool;
 	struct GhostDetails;
 	struct InteractionSet;
 	struct Plantable;
+	struct WorldGenParams;
 
 	class Game: public std::enable_shared_from_this<Game> {
 		public:
 			static constexpr const char *DEFAULT_PATH = "game.g3";
-
-			Canvas &canvas;
-			/** Seconds since the last tick */
+			static constexpr double DEFAULT_TICK_RATE = 60.;
+			static constexpr size_t DEFAULT_MAX_TICKS_PER_FRAME = 8;
+			/** How many seconds of game time make up an in-game hour. */
+			static constexpr double SECONDS_PER_HOUR = 10.;
+
+			/** Null if the game is headless. */
+			Canvas *canvas = nullptr;
+			/** Seconds of game time covered by the current tick. Always 1 / tickRate. */
 			float delta = 0.f;
+			/** How many times per second the game is simulated, independently of the frame rate. */
+			double tickRate = DEFAULT_TICK_RATE;
+			/** The most ticks that tick() will run to catch up after a slow frame. Any time beyond that is dropped
+			 *  instead of being simulated later, so a stall makes the game run slower rather than skip ahead. */
+			size_t maxTicksPerFrame = DEFAULT_MAX_TICKS_PER_FRAME;
+			/** Whether realms are ticked concurrently on the tick pool. Each realm can change itself freely while it ticks;
+			 *  changes to other realms (like entities teleporting into them, or sales to a keep) are deferred until every
+			 *  realm has ticked. Off by default, like Realm::parallelTick. */
+			bool parallelRealms = false;
 			std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
 			bool debugMode = true;
 			/** 12 because the game starts at noon */
 			float hourOffset = 12.;
 			size_t cavesGenerated = 0;
+			/** The save container the game is being loaded from, if any. Tilemaps can use regions from it in place. Only set
+			 *  while loading; chunks that still refer to the mapping afterward keep it alive on their own. */
+			std::shared_ptr<MappedFile> mappedSave;
 			std::map<RealmType, std::shared_ptr<InteractionSet>> interactionSets;
 			std::map<Identifier, std::unordered_set<std::shared_ptr<Item>>> itemsByAttribute;
 
@@ -68,6 +88,10 @@ namespace Game3 {
 			void initialSetup(const std::filesystem::path &dir = "data");
 			void initEntities();
 			void initInteractionSets();
+			/** Generates a new overworld as realm 1 and puts a new player in it. */
+			void generateWorld(size_t seed, int width, int height, const WorldGenParams &);
+			/** Finishes setting up a game loaded with fromJSON: initializes entities, rebuilds path maps and finds the player. */
+			void initAfterLoad();
 			void add(std::shared_ptr<Item>);
 			void add(std::shared_ptr<GhostDetails>);
 			void add(EntityFactory &&);
@@ -77,37 +101,64 @@ namespace Game3 {
 			void traverseData(const std::filesystem::path &);
 			void loadDataFile(const std::filesystem::path &);
 			void addRecipe(const nlohmann::json &);
+			/** Serializes the game, compressing tilemaps with the given zstd level (or storing them uncompressed if it's
+			 *  Tilemap::UNCOMPRESSED). to_json uses the default level. */
+			void toJSON(nlohmann::json &, int compression_level = Tilemap::DEFAULT_COMPRESSION_LEVEL) const;
 			// Returns whether the command executed successfully and a message.
 			std::tuple<bool, Glib::ustring> runCommand(const Glib::ustring &);
+			/** Called once per frame. Runs however many fixed-length ticks fit into the time since the last call. */
 			void tick();
+			/** Simulates the given number of seconds of game time at the fixed tick rate as quickly as possible, without
+			 *  regard for the wall clock. Returns the number of ticks run. */
+			size_t simulate(double seconds);
 			RealmID newRealmID() const;
 			void setText(const Glib::ustring &text, const Glib::ustring &name = "", bool focus = true, bool ephemeral = false);
 			const Glib::ustring & getText() const;
 			void click(int button, int n, double pos_x, double pos_y);
-			double getTotalSeconds() const;
+			/** Seconds of game time simulated so far. Only changes between ticks. */
+			inline double getTotalSeconds() const { return totalSeconds; }
+			/** Seconds of real time that have accumulated toward the next tick. Used to interpolate rendering between ticks. */
+			inline double getTimeSinceTick() const { return tickAccumulator; }
 			double getHour() const;
 			double getMinute() const;
 			/** The value to divide the color values of the tilemap pixels by. Based on the time of day. */
 			double getDivisor() const;
+			inline bool isHeadless() const { return canvas == nullptr; }
+			/** Does nothing if the game is headless. */
 			void activateContext();
+			/** Throws if the game is headless. */
 			MainWindow & getWindow();
 			/** Translates coordinates relative to the top left corner of the canvas to realm coordinates. */
 			Position translateCanvasCoordinates(double x, double y) const;
 			Gdk::Rectangle getVisibleRealmBounds() const;
+			/** Worker threads shared by realms that tick in parallel. Created on first use. */
+			ThreadPool & getTickPool();
 
 			sigc::signal<void(const PlayerPtr &)> signal_player_inventory_update() const { return signal_player_inventory_update_; }
 			sigc::signal<void(const PlayerPtr &)> signal_player_money_update() const { return signal_player_money_update_; }
 			sigc::signal<void(const std::shared_ptr<HasRealm> &)> signal_other_inventory_update()  const { return signal_other_inventory_update_; }
 
 			static std::shared_ptr<Game> create(Canvas &);
-			static std::shared_ptr<Game> fromJSON(const nlohmann::json &, Canvas &);
+			static std::shared_ptr<Game> fromJSON(const nlohmann::json &, Canvas &, std::shared_ptr<MappedFile> mapped_save = nullptr);
+			/** Creates a game with no canvas, window or OpenGL context. Nothing can be rendered, but everything else works. */
+			static std::shared_ptr<Game> createHeadless();
+			static std::shared_ptr<Game> fromJSONHeadless(const nlohmann::json &, std::shared_ptr<MappedFile> mapped_save = nullptr);
 
 		private:
-			Game(Canvas &canvas_): canvas(canvas_) {}
+			Game(Canvas *canvas_): canvas(canvas_) {}
 			sigc::signal<void(const PlayerPtr &)> signal_player_inventory_update_;
 			sigc::signal<void(const PlayerPtr &)> signal_player_money_update_;
 			sigc::signal<void(const std::shared_ptr<HasRealm> &)> signal_other_inventory_update_;
 			std::chrono::system_clock::time_point lastTime = startTime;
+			double tickAccumulator = 0.;
+			double totalSeconds = 0.;
+
+			void runTick(float delta_);
+			void tickRealms(float delta_);
+			void absorbJSON(const nlohmann::json &, std::shared_ptr<MappedFile> mapped_save);
+			std::shared_ptr<ThreadPool> tickPool;
+			/** Changes deferred by each realm ticked in parallel, kept between ticks to reuse their storage. */
+			std::vector<std::vector<std::function<void()>>> realmCommands;
 	};
 
 	void to_json(nlohmann::json &, const Game &);
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace Game3 {
+	/** Runs the game without GTK or OpenGL: game3 --headless <hours> <output path> [input path]
+	 *  Loads the input save if one is given and generates a new world otherwise, simulates the given number of in-game hours
+	 *  as fast as the CPU allows, prints the tick throughput and saves the result to the output path. */
+	int runHeadless(int argc, char **argv);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <filesystem>
+
+#include <nlohmann/json.hpp>
+
+namespace Game3 {
+	class MappedFile;
+
+	/** Writes a save container: an 8-byte magic string, the size of the document as a little-endian uint64, the document as CBOR
+	 *  and then every binary value from the document, each starting at a multiple of 8 bytes. Binary values are replaced in the
+	 *  document with objects containing "blobOffset" and "blobSize". The file is written beside the destination and then renamed
+	 *  over it, so a save that's currently memory-mapped is never truncated. */
+	void writeSave(const std::filesystem::path &, nlohmann::json);
+	bool isSaveContainer(const MappedFile &);
+	/** Reads just the header, so that a file can be checked before deciding whether to map it or read it whole. */
+	bool isSaveContainer(const std::filesystem::path &);
+	/** Parses the document in a save container. Blob offsets in the result are relative to the start of the file. */
+	nlohmann::json readSave(const MappedFile &);
+}
@@ -29,6 +29,6 @@ namespace Game3 {
 			Cave(Game &, RealmID, RealmID parent_realm, TilemapPtr tilemap1_, BiomeMapPtr, int seed_);
 
 			void absorbJSON(const nlohmann::json &) override;
-			void toJSON(nlohmann::json &) const override;
+			void toJSON(nlohmann::json &, int compression_level) const override;
 	};
 }
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+
+#include "Types.h"
+
+namespace Game3 {
+	class Tileset;
+
+	/** The tiles at one position in a realm along with precomputed flags, packed together so that movement and
+	 *  pathfinding checks can be answered with a single memory access instead of a read from each layer plus a
+	 *  tile entity lookup. */
+	struct CellRecord {
+		enum Flags: uint16_t {
+			/** All three layers are walkable. */
+			WALKABLE          = 1 << 0,
+			/** Layer 1 is walkable. */
+			GROUND_WALKABLE   = 1 << 1,
+			/** Layer 2 or layer 3 is solid. */
+			SOLID             = 1 << 2,
+			/** A solid tile entity occupies the position. */
+			SOLID_TILE_ENTITY = 1 << 3,
+			/** Layer 1 is land. */
+			LAND              = 1 << 4,
+		};
+
+		std::array<TileID, 3> layers {};
+		uint16_t flags = 0;
+
+		/** Stores the given tiles and recomputes the tile flags, leaving SOLID_TILE_ENTITY alone. */
+		void update(TileID layer1, TileID layer2, TileID layer3, const Tileset &);
+
+		inline void setSolidTileEntity(bool value) {
+			if (value)
+				flags |= SOLID_TILE_ENTITY;
+			else
+				flags &= ~SOLID_TILE_ENTITY;
+		}
+
+		/** Whether the position is open for pathfinding. */
+		inline bool isPathable() const { return (flags & (WALKABLE | SOLID_TILE_ENTITY)) == WALKABLE; }
+		/** Whether an entity can step onto the position. */
+		inline bool isPassable() const { return (flags & (GROUND_WALKABLE | SOLID | SOLID_TILE_ENTITY)) == GROUND_WALKABLE; }
+		inline bool isLand() const { return (flags & LAND) != 0; }
+	};
+
+	static_assert(sizeof(CellRecord) == 8);
+}
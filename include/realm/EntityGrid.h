@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Position.h"
+#include "Types.h"
+#include "realm/RealmJournal.h"
+
+namespace Game3 {
+	class Entity;
+
+	/** Buckets a realm's entities by position so that lookups only have to look at the entities near the queried area.
+	 *  Each bucket covers a BUCKET_SIZE × BUCKET_SIZE square of tiles. Positions outside the realm are clamped to the
+	 *  nearest bucket. The grid remembers which bucket each entity was put in, so an entity can be moved or removed
+	 *  even if its position has already changed to something that refers to a different realm. */
+	class EntityGrid {
+		public:
+			constexpr static Index BUCKET_SHIFT = 4;
+			constexpr static Index BUCKET_SIZE  = Index(1) << BUCKET_SHIFT;
+
+			EntityGrid() = default;
+
+			/** Removes all entities and sizes the grid for a realm of the given dimensions. */
+			void reset(Index width, Index height);
+			void clear();
+			void insert(const std::shared_ptr<Entity> &);
+			void remove(const std::shared_ptr<Entity> &);
+			/** Moves an entity to the bucket for its current position. Does nothing if the entity isn't in the grid. */
+			void update(const std::shared_ptr<Entity> &);
+			inline bool contains(const std::shared_ptr<Entity> &entity) const { return bucketIndices.contains(entity.get()); }
+			inline size_t size() const { return bucketIndices.size(); }
+
+			/** Calls the visitor with every entity whose position is in the rectangle. The visitor can return true to stop early. */
+			template <typename F>
+			void visit(const TileRect &rect, F &&visitor) const {
+				if (buckets.empty() || rect.width <= 0 || rect.height <= 0)
+					return;
+				const Index last_row    = rect.row + rect.height - 1;
+				const Index last_column = rect.column + rect.width - 1;
+				const Index bucket_row_min    = clampRow(rect.row);
+				const Index bucket_row_max    = clampRow(last_row);
+				const Index bucket_column_min = clampColumn(rect.column);
+				const Index bucket_column_max = clampColumn(last_column);
+				for (Index bucket_row = bucket_row_min; bucket_row <= bucket_row_max; ++bucket_row)
+					for (Index bucket_column = bucket_column_min; bucket_column <= bucket_column_max; ++bucket_column)
+						for (const auto &entity: buckets[bucket_row * bucketColumns + bucket_column])
+							if (rect.contains(entityPosition(*entity)) && visitor(entity))
+								return;
+			}
+
+			std::vector<std::shared_ptr<Entity>> find(const Position &) const;
+			std::vector<std::shared_ptr<Entity>> find(const TileRect &) const;
+			/** Returns the entities whose distance from the center is at most the radius. */
+			std::vector<std::shared_ptr<Entity>> find(const Position &center, double radius) const;
+
+		private:
+			Index bucketRows = 0;
+			Index bucketColumns = 0;
+			std::vector<std::vector<std::shared_ptr<Entity>>> buckets;
+			/** Maps each entity in the grid to the index of the bucket it's in. */
+			std::unordered_map<const Entity *, size_t> bucketIndices;
+
+			Index clampRow(Index row) const;
+			Index clampColumn(Index column) const;
+			size_t getBucketIndex(const Position &) const;
+			void eraseFromBucket(const Entity *, size_t bucket_index);
+
+			/** Entity is incomplete here. */
+			static const Position & entityPosition(const Entity &);
+	};
+}
@@ -32,6 +32,6 @@ namespace Game3 {
 			Keep(Game &, RealmID, const Position &parent_origin, Index parent_width, Index parent_height, TilemapPtr tilemap1_, BiomeMapPtr, int seed_);
 
 			void absorbJSON(const nlohmann::json &) override;
-			void toJSON(nlohmann::json &) const override;
+			void toJSON(nlohmann::json &, int compression_level) const override;
 	};
 }
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "lib/Eigen.h"
+
+namespace Game3 {
+	class Entity;
+
+	/** Holds the movement offsets, speeds and next path steps of a realm's entities in contiguous arrays. Easing every
+	 *  offset toward zero is one vectorized pass over the arrays, and finding the entities that can take their next
+	 *  path step is one scan over them, so an entity is only visited when it's about to cross into another tile.
+	 *  Positions and the paths themselves stay on the entities, which are what the rest of the realm reads. Entities
+	 *  remember which system they're in and their slot in it, and read and write their offsets through those. An
+	 *  entity's speed and path are read when it's added. Entities call updateSpeed and updatePath through
+	 *  Entity::onSpeedChanged and Entity::onPathChanged when they change afterward. */
+	class MovementSystem {
+		public:
+			MovementSystem() = default;
+			~MovementSystem();
+
+			MovementSystem(const MovementSystem &) = delete;
+			MovementSystem(MovementSystem &&) = delete;
+			MovementSystem & operator=(const MovementSystem &) = delete;
+			MovementSystem & operator=(MovementSystem &&) = delete;
+
+			/** Gives the entity a slot with a zero offset. Does nothing if the entity is already in this system. */
+			void add(Entity &);
+			/** Does nothing if the entity isn't in this system. */
+			void remove(Entity &);
+			void clear();
+			void updateSpeed(const Entity &);
+			void updatePath(const Entity &);
+
+			inline Eigen::Vector2f getOffset(size_t slot) const { return {offsetX[slot], offsetY[slot]}; }
+			inline void setOffset(size_t slot, const Eigen::Vector2f &offset) {
+				offsetX[slot] = offset.x();
+				offsetY[slot] = offset.y();
+			}
+
+			/** Has every entity whose offset along its next path step's axis is zero take that step. */
+			void followPaths();
+			/** Moves every offset toward zero by the distance its entity covers in the given number of seconds. */
+			void ease(float delta);
+			inline size_t size() const { return owners.size(); }
+
+		private:
+			/** The axis of each entity's next path step. */
+			enum Axis: uint8_t {NONE = 0, HORIZONTAL, VERTICAL};
+
+			std::vector<float> offsetX;
+			std::vector<float> offsetY;
+			std::vector<float> speeds;
+			std::vector<Axis> nextAxes;
+			std::vector<Entity *> owners;
+			/** Reused by followPaths. */
+			std::vector<Entity *> ready;
+
+			static Axis getNextAxis(const Entity &);
+	};
+}
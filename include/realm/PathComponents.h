@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Position.h"
+#include "Types.h"
+
+namespace Game3 {
+	class PathMap;
+
+	/** Labels each pathable position in a realm with the 4-connected component of the path map it belongs to, so that
+	 *  whether one position can be reached from another can be answered without a search. Unpathable positions are
+	 *  labeled NONE. Labels are arbitrary and change whenever components are merged, split or rebuilt. */
+	class PathComponents {
+		public:
+			using Label = uint32_t;
+			constexpr static Label NONE = 0;
+			/** How many rows each thread labels at a time in a rebuild. */
+			constexpr static Index BAND_ROWS = 32;
+
+			PathComponents() = default;
+
+			/** Relabels everything with a union-find. Row bands are joined in parallel and then stitched together. */
+			void rebuild(const PathMap &, Index width_, Index height_);
+			/** Updates the labels after one position's bit in the path map changed. The path map must already have the
+			 *  new bit, and no other bits may have changed since the labels were last brought up to date. */
+			void update(const PathMap &, Index);
+
+			inline Label operator[](Index index) const { return labels[index]; }
+			inline bool empty() const { return labels.empty(); }
+
+		private:
+			Index width  = 0;
+			Index height = 0;
+			std::vector<Label> labels;
+			/** The number of positions with each label. Indexed by label; labels that aren't in use have size 0. */
+			std::vector<Index> sizes;
+			/** Labels whose components have been emptied by merges or splits, to be handed out again. */
+			std::vector<Label> freeLabels;
+
+			Label makeLabel();
+			void releaseLabel(Label);
+			/** Gives the label to every position reachable from the start that doesn't already have it and returns how
+			 *  many positions were relabeled. */
+			Index fill(const PathMap &, Index start, Label);
+			/** Whether all the pathable orthogonal neighbors of the position are connected to each other through the
+			 *  eight positions around it. If so, making the position unpathable can't split its component. */
+			bool ringConnects(const PathMap &, const Position &) const;
+	};
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Position.h"
+#include "Types.h"
+#include "util/Parallel.h"
+
+namespace Game3 {
+	/** Whether each position in a realm is open for pathfinding, stored as one bit per position in row-major order.
+	 *  Rows aren't padded, so a row can start partway through a word. */
+	class PathMap {
+		public:
+			using Word = uint64_t;
+			constexpr static Index WORD_BITS = 64;
+			/** How many words each thread fills at a time in a parallel rebuild. */
+			constexpr static size_t BAND_WORDS = 64;
+
+			/** Bits returned by getNeighbors. */
+			enum Neighbor: uint8_t {
+				UP    = 1 << 0,
+				LEFT  = 1 << 1,
+				RIGHT = 1 << 2,
+				DOWN  = 1 << 3,
+			};
+
+			PathMap() = default;
+
+			/** Clears every bit. */
+			void resize(Index width_, Index height_) {
+				width  = width_;
+				height = height_;
+				words.assign((width * height + WORD_BITS - 1) / WORD_BITS, 0);
+			}
+
+			inline size_t size() const { return static_cast<size_t>(width * height); }
+			inline bool empty() const { return words.empty(); }
+
+			inline bool operator[](Index index) const {
+				return (words[index / WORD_BITS] >> (index % WORD_BITS)) & 1;
+			}
+
+			/** Throws std::out_of_range for a bad index. */
+			bool at(Index index) const {
+				if (index < 0 || width * height <= index)
+					throw std::out_of_range("Invalid path map index: " + std::to_string(index));
+				return (*this)[index];
+			}
+
+			inline void set(Index index, bool value) {
+				const Word bit = Word(1) << (index % WORD_BITS);
+				if (value)
+					words[index / WORD_BITS] |= bit;
+				else
+					words[index / WORD_BITS] &= ~bit;
+			}
+
+			/** Returns the WORD_BITS bits starting at the index. Bits past the end of the map are zero. */
+			inline Word getWord(Index index) const {
+				const size_t word  = index / WORD_BITS;
+				const Index  shift = index % WORD_BITS;
+				Word out = words[word] >> shift;
+				if (shift != 0 && word + 1 < words.size())
+					out |= words[word + 1] << (WORD_BITS - shift);
+				return out;
+			}
+
+			/** Returns a combination of Neighbor bits for the pathable positions next to the given one. Both horizontal
+			 *  neighbors come from a single getWord. */
+			uint8_t getNeighbors(const Position &position) const {
+				const Index index = position.row * width + position.column;
+				uint8_t out = 0;
+
+				if (0 < position.row && (*this)[index - width])
+					out |= UP;
+
+				if (position.row < height - 1 && (*this)[index + width])
+					out |= DOWN;
+
+				if (0 < position.column) {
+					const Word row_bits = getWord(index - 1);
+					if (row_bits & 1)
+						out |= LEFT;
+					if (position.column < width - 1 && (row_bits & 4))
+						out |= RIGHT;
+				} else if (position.column < width - 1 && (*this)[index + 1]) {
+					out |= RIGHT;
+				}
+
+				return out;
+			}
+
+			/** Sets the bits in [begin, end) to the predicate's result for each index, a word at a time. */
+			template <typename P>
+			void fill(Index begin, Index end, const P &predicate) {
+				while (begin < end) {
+					const size_t word = begin / WORD_BITS;
+					const Index stop = std::min<Index>(end, (word + 1) * WORD_BITS);
+					Word mask = 0;
+					Word bits = 0;
+					for (Index index = begin; index < stop; ++index) {
+						const Word bit = Word(1) << (index % WORD_BITS);
+						mask |= bit;
+						if (predicate(index))
+							bits |= bit;
+					}
+					words[word] = (words[word] & ~mask) | bits;
+					begin = stop;
+				}
+			}
+
+			/** Sets every bit to the predicate's result for its index. The predicate is called from several threads at
+			 *  once. Each thread fills whole words, so no two threads write to the same word. */
+			template <typename P>
+			void fillParallel(const P &predicate) {
+				const Index band_size = BAND_WORDS * WORD_BITS;
+				const Index total = width * height;
+				parallelFor((words.size() + BAND_WORDS - 1) / BAND_WORDS, [&](size_t band) {
+					const Index begin = band * band_size;
+					fill(begin, std::min(total, begin + band_size), predicate);
+				});
+			}
+
+		private:
+			Index width  = 0;
+			Index height = 0;
+			std::vector<Word> words;
+	};
+}
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <queue>
 #include <random>
 #include <unordered_map>
 #include <unordered_set>
@@ -12,9 +16,18 @@
 #include "Tilemap.h"
 #include "Types.h"
 #include "game/BiomeMap.h"
+#include "realm/CellRecord.h"
+#include "realm/EntityGrid.h"
+#include "realm/MovementSystem.h"
+#include "realm/PathComponents.h"
+#include "realm/PathMap.h"
+#include "realm/RealmJournal.h"
+#include "realm/TileEntityIndex.h"
+#include "realm/TileEntitySlots.h"
 #include "tileentity/TileEntity.h"
 #include "ui/ElementBufferedRenderer.h"
 #include "util/GL.h"
+#include "util/ObjectPool.h"
 #include "util/RWLock.h"
 
 namespace Game3 {
@@ -41,19 +54,41 @@ namespace Game3 {
 			TilemapPtr tilemap2;
 			TilemapPtr tilemap3;
 			BiomeMapPtr biomeMap;
-			ElementBufferedRenderer renderer1 {*this};
-			ElementBufferedRenderer renderer2 {*this};
-			ElementBufferedRenderer renderer3 {*this};
+			ElementBufferedRenderer renderer1 {*this, 1};
+			ElementBufferedRenderer renderer2 {*this, 2};
+			ElementBufferedRenderer renderer3 {*this, 3};
 			std::unordered_map<Index, std::shared_ptr<TileEntity>> tileEntities;
 			std::unordered_set<std::shared_ptr<Entity>> entities;
-			/** A vector of bools (represented with uint8_t to avoid the std::vector<bool> specialization) indicating whether a given square is empty for the purposes of pathfinding. */
-			std::vector<uint8_t> pathMap;
+			/** Whether each square is empty for the purposes of pathfinding. */
+			PathMap pathMap;
 			nlohmann::json extraData;
 			Index randomLand = 0;
 			/** Whether the realm's rendering should be affected by the day-night cycle. */
 			bool outdoors = true;
+			/** Entities and tile entities made while generating, loading or ticking this realm are allocated from here.
+			 *  The pool lives until the realm and all of its objects are gone. */
+			std::shared_ptr<ObjectPool> objectPool = std::make_shared<ObjectPool>();
 			size_t ghostCount = 0;
 			uint32_t seed = 0;
+			RealmJournal journal;
+			/** Whether tick() splits the realm into square regions and ticks regions that don't touch each other concurrently.
+			 *  Changes that entities and tile entities make to realms while their region is ticking are deferred until all
+			 *  regions have been ticked. */
+			bool parallelTick = false;
+			/** Seconds that this realm has been ticked for since it was created or loaded. Sleeping tile entities are
+			 *  scheduled against this. Atomic so that other realms' threads can read it while this realm ticks. */
+			std::atomic<double> simulatedTime = 0.;
+
+			constexpr static Index TICK_REGION_SIZE = 32;
+			/** Seconds of game time between the catch-up steps of an idle realm. */
+			constexpr static float IDLE_TICK_INTERVAL = 1.f;
+
+			enum class Activity: uint8_t {
+				/** Ticked every game tick: the active realm and realms with busy entities in them (see Entity::isBusy). */
+				Full,
+				/** Caught up every IDLE_TICK_INTERVAL seconds. */
+				Idle,
+			};
 
 			Realm(const Realm &) = delete;
 			Realm(Realm &&) = delete;
@@ -79,18 +114,39 @@ namespace Game3 {
 			std::shared_ptr<TileEntity> add(const std::shared_ptr<TileEntity> &);
 			std::shared_ptr<TileEntity> addUnsafe(const std::shared_ptr<TileEntity> &);
 			void initEntities();
+			/** Ticks the realm as often as its activity level calls for. Idle realms save up the time they skip and simulate it
+			 *  in one catch-up step every IDLE_TICK_INTERVAL seconds, or as soon as they become fully active again. */
+			void update(float delta);
 			void tick(float delta);
+			/** Simulates a long stretch of time in one step. Entities other than players are advanced with Entity::catchUp. */
+			void catchUp(float delta);
+			Activity getActivity() const;
 			std::vector<std::shared_ptr<Entity>> findEntities(const Position &) const;
 			std::vector<std::shared_ptr<Entity>> findEntities(const Position &, const std::shared_ptr<Entity> &except) const;
 			std::shared_ptr<Entity> findEntity(const Position &) const;
 			std::shared_ptr<Entity> findEntity(const Position &, const std::shared_ptr<Entity> &except) const;
+			std::vector<std::shared_ptr<Entity>> findEntities(const TileRect &) const;
+			/** Returns the entities whose distance from the center is at most the radius. */
+			std::vector<std::shared_ptr<Entity>> findEntities(const Position &center, double radius) const;
+			inline const EntityGrid & getEntityGrid() const { return entityGrid; }
 			std::shared_ptr<TileEntity> tileEntityAt(const Position &);
 			void remove(std::shared_ptr<Entity>);
 			void remove(const std::shared_ptr<TileEntity> &, bool run_helper = true);
 			void removeSafe(const std::shared_ptr<TileEntity> &);
 			Position getPosition(Index) const;
-			void onMoved(const std::shared_ptr<Entity> &, const Position &);
+			void onMoved(const std::shared_ptr<Entity> &, const Position &old_position, const Position &new_position);
 			Game & getGame();
+			/** Runs the function now, or after the parallel tick if this realm can't be changed from the current thread yet:
+			 *  while ticking a region of any realm, or while ticking a different realm alongside this one. */
+			void defer(std::function<void()>);
+			/** For things that aren't owned by one realm, like the UI or reads from other realms: runs the function now, or
+			 *  once the current parallel tick is over if called while ticking in parallel. */
+			static void deferShared(std::function<void()>);
+			static bool isTickingInParallel();
+			/** Releases removed tile entities that no thread can still be looking up. Called by the game between ticks. */
+			void reclaimTileEntities();
+			/** Puts a sleeping tile entity back on the list of tile entities ticked every tick. */
+			void wakeTileEntity(const std::shared_ptr<TileEntity> &);
 			void queueRemoval(const std::shared_ptr<Entity> &);
 			void queueRemoval(const std::shared_ptr<TileEntity> &);
 			void absorb(const std::shared_ptr<Entity> &, const Position &);
@@ -127,13 +183,71 @@ namespace Game3 {
 			void confirmGhosts();
 			void damageGround(const Position &);
 			const Tileset & getTileset() const;
+			/** Rebuilds the whole path map, in parallel. */
 			void remakePathMap();
+			/** Recomputes the path map for the positions in the rectangle only and relabels the path components if anything
+			 *  changed. Used for transactions that edit too much to update the components position by position. */
+			void updatePathMap(const TileRect &);
+			/** Sets one position's path map bit and keeps the path components up to date. */
+			void setPathable(Index, bool);
+			/** Returns the label of the path component the position is in, or PathComponents::NONE if it isn't pathable. */
+			PathComponents::Label getPathComponent(const Position &) const;
+			/** Whether a path exists from one position to the other. Takes constant time. The starting position doesn't
+			 *  have to be pathable itself as long as one of its neighbors is. */
+			bool isReachable(const Position &from, const Position &to) const;
+			/** Like getPathableAdjacent, but only returns a position that can be reached from the given one. */
+			std::optional<Position> getReachableAdjacent(const Position &, const Position &from) const;
+			/** Whether the realm keeps an up-to-date CellRecord for every position. */
+			inline bool hasCells() const { return !cells.empty(); }
+			/** Only valid if hasCells() returns true. */
+			inline const CellRecord & getCell(Index index) const { return cells[index]; }
+			inline const CellRecord & getCell(const Position &position) const { return cells[getIndex(position)]; }
+			/** Cells are disabled by default because they cost eight bytes per position in every realm. Enabling them makes
+			 *  movement and path map checks read one record instead of three tilemaps. */
+			void setCellsEnabled(bool);
+			/** Rebuilds every cell from the tilemaps, e.g. after the tilemaps have been written to directly. Does nothing if cells are disabled. */
+			void remakeCells();
 
 			virtual bool interactGround(const std::shared_ptr<Player> &, const Position &);
+			/** Re-marches the tiles around the position and tells the tile entities next to it that it changed. */
 			virtual void updateNeighbors(const Position &);
+			/** Like updateNeighbors(const Position &) for every position in the rectangle, but done in one pass. */
+			void updateNeighbors(const TileRect &);
 			/** Returns true iff something was done with the right click. */
 			virtual bool rightClick(const Position &, double x, double y);
 
+			/** While a batch exists, neighbor updates and reuploads for the realm are only recorded. When the outermost batch
+			 *  ends, every affected cell is re-marched and notified once and the renderers are uploaded at most once. */
+			class NeighborBatch {
+				public:
+					explicit NeighborBatch(Realm &);
+					~NeighborBatch();
+
+					NeighborBatch(const NeighborBatch &) = delete;
+					NeighborBatch & operator=(const NeighborBatch &) = delete;
+
+				private:
+					Realm &realm;
+			};
+
+			/** Makes tile edits cheaper by putting off updates to the state derived from tiles until the outermost
+			 *  transaction ends. Edits made inside one only write tiles, journal them and update cells. At the end, the
+			 *  path map, the lava quadtrees, marching and the renderers are brought up to date once for every edited
+			 *  position. Meant for bulk edits like world generation. */
+			class Transaction {
+				public:
+					explicit Transaction(Realm &);
+					~Transaction();
+
+					Transaction(const Transaction &) = delete;
+					Transaction & operator=(const Transaction &) = delete;
+
+				private:
+					Realm &realm;
+					/** Destroyed after the transaction commits, so the marching it queues is done at the end. */
+					NeighborBatch neighborBatch;
+			};
+
 			template <typename T, typename... Args>
 			std::shared_ptr<T> spawn(const Position &position, Args && ...args) {
 				Game &game_ref = getGame();
@@ -145,15 +259,26 @@ namespace Game3 {
 				return entity;
 			}
 
+			/** Calls the visitor with every tile entity that is a T. The visitor can return true to stop early. */
+			template <typename T, typename F>
+			void iterateTileEntities(F &&visitor) const {
+				tileEntityIndex.visit<T>(std::forward<F>(visitor));
+			}
+
+			/** Returns the tile entities with the given tile ID, keyed by index. */
+			inline const TileEntityIndex::Bucket & getTileEntitiesByTileID(const Identifier &tile_id) const {
+				return tileEntityIndex.getByTileID(tile_id);
+			}
+
 			template <typename T>
 			std::shared_ptr<T> getTileEntity() const {
 				std::shared_ptr<T> out;
-				for (const auto &[index, tile_entity]: tileEntities)
-					if (auto cast = std::dynamic_pointer_cast<T>(tile_entity)) {
-						if (out)
-							throw std::runtime_error("Multiple tile entities of type " + std::string(typeid(T).name()) + " found");
-						out = cast;
-					}
+				tileEntityIndex.visit<T>([&](const std::shared_ptr<T> &tile_entity) {
+					if (out)
+						throw std::runtime_error("Multiple tile entities of type " + std::string(typeid(T).name()) + " found");
+					out = tile_entity;
+					return false;
+				});
 				if (!out)
 					throw std::runtime_error("No tile entities of type " + std::string(typeid(T).name()) + " found");
 				return out;
@@ -162,14 +287,14 @@ namespace Game3 {
 			template <typename T, typename P>
 			std::shared_ptr<T> getTileEntity(const P &predicate) const {
 				std::shared_ptr<T> out;
-				for (const auto &[index, tile_entity]: tileEntities)
-					if (auto cast = std::dynamic_pointer_cast<T>(tile_entity)) {
-						if (predicate(cast)) {
-							if (out)
-								throw std::runtime_error("Multiple tile entities of type " + std::string(typeid(T).name()) + " found");
-							out = cast;
-						}
+				tileEntityIndex.visit<T>([&](const std::shared_ptr<T> &tile_entity) {
+					if (predicate(tile_entity)) {
+						if (out)
+							throw std::runtime_error("Multiple tile entities of type " + std::string(typeid(T).name()) + " found");
+						out = tile_entity;
 					}
+					return false;
+				});
 				if (!out)
 					throw std::runtime_error("No tile entities of type " + std::string(typeid(T).name()) + " found");
 				return out;
@@ -177,38 +302,25 @@ namespace Game3 {
 
 			template <typename T>
 			std::shared_ptr<T> closestTileEntity(const Position &position) const {
-				double minimum_distance = INFINITY;
-				std::shared_ptr<T> out;
-				for (const auto &[index, entity]: tileEntities)
-					if (auto cast = std::dynamic_pointer_cast<T>(entity)) {
-						const double distance = entity->position.distance(position);
-						if (distance < minimum_distance) {
-							minimum_distance = distance;
-							out = cast;
-						}
-					}
-				if (!out)
-					throw std::runtime_error("No tile entities of type " + std::string(typeid(T).name()) + " found");
-				return out;
+				if (auto out = tileEntityIndex.nearest<T>(position))
+					return out;
+				throw std::runtime_error("No tile entities of type " + std::string(typeid(T).name()) + " found");
 			}
 
 			template <typename T, typename P>
 			std::shared_ptr<T> closestTileEntity(const Position &position, const P &predicate) const {
-				double minimum_distance = INFINITY;
-				std::shared_ptr<T> out;
-				for (const auto &[index, entity]: tileEntities)
-					if (auto cast = std::dynamic_pointer_cast<T>(entity)) {
-						const double distance = entity->position.distance(position);
-						if (predicate(cast) && distance < minimum_distance) {
-							minimum_distance = distance;
-							out = cast;
-						}
-					}
-				if (!out)
-					throw std::runtime_error("No tile entities of type " + std::string(typeid(T).name()) + " found");
-				return out;
+				if (auto out = tileEntityIndex.nearest<T>(position, predicate))
+					return out;
+				throw std::runtime_error("No tile entities of type " + std::string(typeid(T).name()) + " found");
+			}
+
+			/** Like closestTileEntity, but returns null instead of throwing if nothing within max_distance matches. */
+			template <typename T, typename P>
+			std::shared_ptr<T> closestTileEntity(const Position &position, const P &predicate, double max_distance) const {
+				return tileEntityIndex.nearest<T>(position, predicate, max_distance);
 			}
 
+			friend class Game;
 			friend class MainWindow;
 			friend void to_json(nlohmann::json &, const Realm &);
 
@@ -219,18 +331,87 @@ namespace Game3 {
 
 			void initTexture();
 			virtual void absorbJSON(const nlohmann::json &);
-			virtual void toJSON(nlohmann::json &) const;
+			/** Tilemaps are compressed with the given zstd level (or stored uncompressed if it's Tilemap::UNCOMPRESSED). */
+			virtual void toJSON(nlohmann::json &, int compression_level) const;
+			/** Refreshes a cell from the tilemaps after one of its tiles has been changed directly. */
+			void updateCell(Index);
 
 		private:
+			/** The things in one region for a parallel tick, plus the changes they deferred. */
+			struct TickRegion {
+				std::vector<std::shared_ptr<Entity>> entities;
+				std::vector<std::shared_ptr<TileEntity>> tileEntities;
+				std::vector<std::function<void()>> commands;
+			};
+
+			struct SleepEntry {
+				double wakeTime;
+				std::weak_ptr<TileEntity> tileEntity;
+				inline bool operator>(const SleepEntry &other) const { return wakeTime > other.wakeTime; }
+			};
+
 			Game &game;
 			bool ticking = false;
+			/** Tile entities that get ticked every tick. The rest are asleep. */
+			std::unordered_set<std::shared_ptr<TileEntity>> awakeTileEntities;
+			/** Sleeping tile entities ordered by wake time. Entries can be stale if a tile entity was woken early or removed. */
+			std::priority_queue<SleepEntry, std::vector<SleepEntry>, std::greater<>> sleepingTileEntities;
+			/** The awake tile entities as of the start of the current tick. Reused between ticks. */
+			std::vector<std::shared_ptr<TileEntity>> tickingTileEntities;
+			/** Reused between ticks to avoid reallocating. */
+			std::vector<TickRegion> tickRegions;
 			std::vector<std::shared_ptr<Entity>> entityRemovalQueue;
 			std::vector<std::shared_ptr<TileEntity>> tileEntityRemovalQueue;
 			RWLock tileEntityLock;
+			/** Row-major. Empty until the path map is first made or if cells are disabled. */
+			std::vector<CellRecord> cells;
+			bool cellsEnabled = false;
+			/** Kept in sync with entities. */
+			EntityGrid entityGrid;
+			/** Kept in sync with tileEntities. */
+			TileEntityIndex tileEntityIndex;
+			/** Kept in sync with tileEntities. Lets tileEntityAt read without taking tileEntityLock. */
+			TileEntitySlots tileEntitySlots;
+			/** Holds the movement offsets of the entities in entities. Declared after entities so that it's destroyed
+			 *  while they're still alive. */
+			MovementSystem movement;
+			/** Indices of changed positions whose neighbors haven't been updated yet. */
+			std::vector<Index> pendingNeighborUpdates;
+			size_t neighborBatchDepth = 0;
+			/** Whether reupload() was called during a NeighborBatch. */
+			bool reuploadPending = false;
+			size_t transactionDepth = 0;
+			/** Indices written to each layer during a transaction, if that layer has a lava quadtree to update. */
+			std::array<std::vector<Index>, 3> transactionTiles;
+			/** Indices whose path map entries and neighbors have to be updated when the transaction ends. */
+			std::vector<Index> transactionHelpers;
+			/** Kept in sync with pathMap. */
+			PathComponents pathComponents;
 
 			bool isWalkable(Index row, Index column, const Tileset &) const;
-			void setLayerHelper(Index row, Index col, bool should_mark_dirty = true);
-			void setLayerHelper(Index, bool should_mark_dirty = true);
+			/** Writes a tile to a layer (1 to 3), journals it and updates its cell. */
+			void setTile(uint8_t layer, Index, TileID);
+			void setLayerHelper(Index row, Index col);
+			void setLayerHelper(Index);
+			/** Game time skipped since the realm last ticked, while it was idle. */
+			float skippedTime = 0.f;
+
+			void simulate(float delta, bool catch_up);
+			void tickParallel(float delta, bool catch_up);
+			/** Moves tile entities whose wake time has come from sleepingTileEntities to awakeTileEntities. */
+			void wakeDueTileEntities();
+			/** Puts the tile entities that just ticked and asked to sleep into sleepingTileEntities. */
+			void sleepTickedTileEntities();
+			void tickPlayer(const std::shared_ptr<Entity> &, float delta);
+			/** Whether changes to this realm made from the current thread have to be deferred. */
+			bool isDeferring() const;
+			/** Processes pendingNeighborUpdates, including any that are queued while doing so, and then uploads every layer
+			 *  if a reupload is pending. Marched tiles are journaled, so the renderers pick those up by themselves. */
+			void flushNeighborUpdates();
+			/** Re-marches and notifies the neighbors of the changed positions, each once. Sorts the indices. */
+			void marchNeighbors(std::vector<Index> &changed);
+			/** Applies the updates put off by the transaction that just ended. */
+			void commitTransaction();
 
 			static BiomeType getBiome(uint32_t seed);
 	};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Position.h"
+#include "Types.h"
+
+namespace Game3 {
+	class Entity;
+	class TileEntity;
+
+	/** A rectangle of tiles with its top left corner at (row, column). */
+	struct TileRect {
+		Index row = 0;
+		Index column = 0;
+		Index height = 0;
+		Index width = 0;
+
+		inline bool contains(Index row_, Index column_) const { return row <= row_ && row_ < row + height && column <= column_ && column_ < column + width; }
+		inline bool contains(const Position &position) const { return contains(position.row, position.column); }
+	};
+
+	/** Records what changes in a realm so that consumers can update what they derive from it incrementally.
+	 *  Changes are gathered into one entry per tick, with tile edits coalesced into rectangles. Each consumer
+	 *  reads entries through its own cursor. Nothing is recorded while there are no cursors. */
+	class RealmJournal {
+		public:
+			enum class EventType: uint8_t {TileEntityAdded, TileEntityRemoved, EntityAdded, EntityRemoved, EntityMoved};
+
+			struct Event {
+				EventType type;
+				Position position;
+				/** Only meaningful for EntityMoved. */
+				Position oldPosition;
+				std::weak_ptr<Entity> entity;
+				std::weak_ptr<TileEntity> tileEntity;
+			};
+
+			struct Entry {
+				uint64_t sequence = 0;
+				/** Rectangles covering the tiles edited in layers 1, 2 and 3. */
+				std::array<std::vector<TileRect>, 3> dirtyTiles;
+				/** Multiple moves of the same entity within a tick are combined into one event. */
+				std::vector<Event> events;
+			};
+
+			class Cursor {
+				private:
+					uint64_t next = 0;
+					/** Set if entries were discarded before this cursor read them. */
+					bool lost = false;
+
+				friend class RealmJournal;
+			};
+
+			/** The number of committed entries kept for cursors that haven't caught up. Cursors further behind lose entries. */
+			constexpr static size_t MAX_HISTORY = 256;
+
+			RealmJournal() = default;
+			RealmJournal(const RealmJournal &) = delete;
+			RealmJournal(RealmJournal &&) = delete;
+
+			RealmJournal & operator=(const RealmJournal &) = delete;
+			RealmJournal & operator=(RealmJournal &&) = delete;
+
+			/** Returns a cursor that will see every entry committed from now on. Recording stops once all cursors are destroyed. */
+			std::shared_ptr<Cursor> subscribe();
+			/** Visits the entries the cursor hasn't seen yet in order and moves the cursor past them. Returns false if some
+			 *  entries were discarded before the cursor could read them, in which case the consumer should rebuild from scratch. */
+			bool read(Cursor &, const std::function<void(const Entry &)> &);
+
+			/** Layers are numbered from 1 to 3. */
+			void recordTile(uint8_t layer, Index row, Index column);
+			inline void recordTile(uint8_t layer, const Position &position) { recordTile(layer, position.row, position.column); }
+			void recordTileEntity(EventType, const std::shared_ptr<TileEntity> &);
+			void recordEntity(EventType, const std::shared_ptr<Entity> &, const Position &position, const Position &old_position = {});
+			/** Ends the current entry. Called at the end of every realm tick. */
+			void commit();
+
+			inline bool isActive() const { return active.load(std::memory_order_relaxed); }
+
+		private:
+			std::mutex mutex;
+			std::atomic_bool active = false;
+			std::vector<std::weak_ptr<Cursor>> cursors;
+			std::deque<std::shared_ptr<const Entry>> history;
+			uint64_t nextSequence = 0;
+			Entry pending;
+			bool pendingEmpty = true;
+			/** Bounding boxes of the edits in each layer since the last commit, keyed by chunk. */
+			std::array<std::unordered_map<uint64_t, TileRect>, 3> pendingTiles;
+			/** Indices into pending.events of entity moves since the last commit. */
+			std::unordered_map<const Entity *, size_t> pendingMoves;
+
+			void clearPending();
+			/** Drops entries that every cursor has read along with expired cursors. Assumes the mutex is locked. */
+			void prune();
+	};
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include "Position.h"
+#include "Types.h"
+#include "data/Identifier.h"
+#include "tileentity/TileEntity.h"
+
+namespace Game3 {
+	/** Secondary indexes over a realm's tile entities, grouped by their dynamic type and by their tile ID, so that
+	 *  looking for tile entities of one kind doesn't have to look at (and dynamic_cast) every tile entity in the realm.
+	 *  Each type bucket also sorts its tile entities into CELL_SIZE × CELL_SIZE cells for nearest-neighbor searches. */
+	class TileEntityIndex {
+		public:
+			/** Maps realm indices to tile entities, like Realm::tileEntities. */
+			using Bucket = std::unordered_map<Index, std::shared_ptr<TileEntity>>;
+
+			constexpr static Index CELL_SHIFT = 4;
+			constexpr static Index CELL_SIZE  = Index(1) << CELL_SHIFT;
+			/** Type buckets with at most this many tile entities are searched linearly instead of ring by ring. */
+			constexpr static size_t LINEAR_SEARCH_LIMIT = 64;
+
+			TileEntityIndex() = default;
+
+			void insert(Index, const std::shared_ptr<TileEntity> &);
+			void remove(Index, const std::shared_ptr<TileEntity> &);
+			void clear();
+			/** Returns an empty bucket if there are no tile entities with the given tile ID. */
+			const Bucket & getByTileID(const Identifier &) const;
+
+			/** Calls the visitor with every tile entity that is a T (including subclasses of T). The visitor can return
+			 *  true to stop early. Every tile entity in a type bucket has the same dynamic type, so only the first one in
+			 *  each bucket needs to be checked with dynamic_cast. */
+			template <typename T, typename F>
+			void visit(F &&visitor) const {
+				for (const auto &[type, bucket]: byType) {
+					if (!matches<T>(bucket))
+						continue;
+					for (const auto &[index, tile_entity]: bucket.members)
+						if (visitor(std::static_pointer_cast<T>(tile_entity)))
+							return;
+				}
+			}
+
+			/** Returns the closest T to the center that satisfies the predicate and is at most max_distance away, or null
+			 *  if there isn't one. Distances are compared squared. The predicate is only called for tile entities that
+			 *  would be closer than the best one found so far. */
+			template <typename T, typename P>
+			std::shared_ptr<T> nearest(const Position &center, const P &predicate, double max_distance = INFINITY) const {
+				Search<T, P> search(center, predicate, max_distance);
+				for (const auto &[type, bucket]: byType) {
+					if (!matches<T>(bucket))
+						continue;
+					if (bucket.members.size() <= LINEAR_SEARCH_LIMIT)
+						for (const auto &[index, tile_entity]: bucket.members)
+							search.consider(tile_entity);
+					else
+						searchRings(bucket, search);
+				}
+				return search.best;
+			}
+
+			template <typename T>
+			std::shared_ptr<T> nearest(const Position &center, double max_distance = INFINITY) const {
+				return nearest<T>(center, [](const auto &) { return true; }, max_distance);
+			}
+
+		private:
+			struct TypeBucket {
+				Bucket members;
+				std::unordered_map<uint64_t, std::vector<std::shared_ptr<TileEntity>>> cells;
+				/** Bounds of the cells that have held a tile entity. They don't shrink when tile entities are removed. */
+				Index minCellRow    = 0;
+				Index maxCellRow    = -1;
+				Index minCellColumn = 0;
+				Index maxCellColumn = -1;
+			};
+
+			template <typename T, typename P>
+			struct Search {
+				const Position &center;
+				const P &predicate;
+				double maxSquared;
+				std::shared_ptr<T> best;
+				Index bestSquared = 0;
+
+				Search(const Position &center_, const P &predicate_, double max_distance):
+					center(center_), predicate(predicate_), maxSquared(max_distance * max_distance) {}
+
+				void consider(const std::shared_ptr<TileEntity> &tile_entity) {
+					const Index row_difference    = tile_entity->position.row    - center.row;
+					const Index column_difference = tile_entity->position.column - center.column;
+					const Index squared = row_difference * row_difference + column_difference * column_difference;
+					if (maxSquared < static_cast<double>(squared) || (best && bestSquared <= squared))
+						return;
+					auto cast = std::static_pointer_cast<T>(tile_entity);
+					if (!predicate(cast))
+						return;
+					best = std::move(cast);
+					bestSquared = squared;
+				}
+
+				/** Whether anything in a cell at the given Chebyshev cell distance could beat what's been found. */
+				bool worthVisiting(Index ring) const {
+					const Index closest = std::max<Index>(0, (ring - 1) * CELL_SIZE + 1);
+					const Index squared = closest * closest;
+					return static_cast<double>(squared) <= maxSquared && (!best || squared < bestSquared);
+				}
+			};
+
+			std::unordered_map<std::type_index, TypeBucket> byType;
+			std::unordered_map<Identifier, Bucket> byTileID;
+
+			template <typename T>
+			static bool matches(const TypeBucket &bucket) {
+				return !bucket.members.empty() && dynamic_cast<T *>(bucket.members.begin()->second.get());
+			}
+
+			/** Visits the bucket's cells in square rings of increasing size around the center's cell until no remaining
+			 *  ring can contain anything closer than the best match so far. */
+			template <typename T, typename P>
+			static void searchRings(const TypeBucket &bucket, Search<T, P> &search) {
+				const Index center_row    = search.center.row    >> CELL_SHIFT;
+				const Index center_column = search.center.column >> CELL_SHIFT;
+				const Index max_ring = std::max({center_row - bucket.minCellRow, bucket.maxCellRow - center_row, center_column - bucket.minCellColumn, bucket.maxCellColumn - center_column});
+
+				auto visit_cell = [&](Index cell_row, Index cell_column) {
+					if (cell_row < bucket.minCellRow || bucket.maxCellRow < cell_row || cell_column < bucket.minCellColumn || bucket.maxCellColumn < cell_column)
+						return;
+					if (auto iter = bucket.cells.find(getCellKey(cell_row, cell_column)); iter != bucket.cells.end())
+						for (const auto &tile_entity: iter->second)
+							search.consider(tile_entity);
+				};
+
+				for (Index ring = 0; ring <= max_ring && search.worthVisiting(ring); ++ring) {
+					if (ring == 0) {
+						visit_cell(center_row, center_column);
+						continue;
+					}
+					for (Index column = center_column - ring; column <= center_column + ring; ++column) {
+						visit_cell(center_row - ring, column);
+						visit_cell(center_row + ring, column);
+					}
+					for (Index row = center_row - ring + 1; row < center_row + ring; ++row) {
+						visit_cell(row, center_column - ring);
+						visit_cell(row, center_column + ring);
+					}
+				}
+			}
+
+			static inline uint64_t getCellKey(Index cell_row, Index cell_column) {
+				return (static_cast<uint64_t>(static_cast<uint32_t>(cell_row)) << 32) | static_cast<uint32_t>(cell_column);
+			}
+	};
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "Types.h"
+
+namespace Game3 {
+	class TileEntity;
+
+	/** One atomic slot per position in a realm holding the tile entity there, so that tile entities can be looked up by
+	 *  position without taking a lock, from any thread. Writers still have to be serialized with each other. A removed
+	 *  tile entity isn't released right away: it's retired, tagged with the global epoch, and only released by reclaim()
+	 *  once no reader can still be in the middle of loading it. Readers pin the global epoch for the few instructions
+	 *  between loading a slot and taking a reference to what they found, so a retired tile entity can be released as
+	 *  soon as every pinned reader pinned a later epoch. */
+	class TileEntitySlots {
+		public:
+			TileEntitySlots() = default;
+
+			/** Empties every slot and sizes the table for a realm of the given dimensions. Only call this while no other
+			 *  thread can be reading the table. */
+			void reset(Index width, Index height);
+
+			/** Returns null if there's no tile entity at the index or if the index is out of bounds. Safe to call from any
+			 *  thread. */
+			std::shared_ptr<TileEntity> get(Index) const;
+			/** Whether there's a tile entity at the index. Doesn't touch the tile entity's reference count. */
+			inline bool contains(Index index) const {
+				return 0 <= index && index < slotCount && slots[index].load(std::memory_order_acquire) != nullptr;
+			}
+			/** Doesn't take ownership. The caller has to keep the tile entity alive until it's erased. */
+			void set(Index, const std::shared_ptr<TileEntity> &);
+			/** Empties the slot and holds on to the tile entity until it's safe to release. */
+			void erase(Index, std::shared_ptr<TileEntity>);
+			/** Releases the retired tile entities that no reader can still be loading. Must not run concurrently with
+			 *  erase(). */
+			void reclaim();
+			inline size_t retiredCount() const { return retired.size(); }
+
+			/** Called by the game once per tick, after every realm has ticked. */
+			static void advanceGlobalEpoch();
+
+		private:
+			struct Retired {
+				uint64_t epoch;
+				std::shared_ptr<TileEntity> tileEntity;
+			};
+
+			Index slotCount = 0;
+			std::unique_ptr<std::atomic<TileEntity *>[]> slots;
+			/** In order of retirement, so their epochs never decrease. */
+			std::vector<Retired> retired;
+	};
+}
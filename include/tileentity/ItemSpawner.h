@@ -29,5 +29,13 @@ namespace Game3 {
 			ItemSpawner(Position position_, float chance_per_tenth, std::vector<ItemStack> spawnables_);
 
 			friend class TileEntity;
+
+		private:
+			/** The realm time of the next spawn attempt, or negative if none has been scheduled yet. */
+			double nextAttempt = -1.;
+
+			/** Samples the time until the next spawn attempt. Attempts happen with probability chancePerTenth in each tenth
+			 *  of a second, so the waiting time is exponentially distributed. */
+			double sampleDelay() const;
 	};
 }
@@ -21,6 +21,7 @@ namespace Game3 {
 		public:
 			static Identifier ID() { return {"base", "te/ore_deposit"}; }
 			Identifier oreType;
+			/** As of the last update (see TileEntity::markUpdated). Use getTimeRemaining() to read the current value. */
 			float timeRemaining = 0.f;
 			uint32_t uses = 0;
 
@@ -33,10 +34,10 @@ namespace Game3 {
 
 			void toJSON(nlohmann::json &) const override;
 			void absorbJSON(Game &, const nlohmann::json &) override;
-			void tick(Game &, float) override;
 			bool onInteractNextTo(const std::shared_ptr<Player> &) override;
 			void render(SpriteRenderer &) override;
 			const Ore & getOre(const Game &) const;
+			float getTimeRemaining() const;
 
 		protected:
 			OreDeposit() = default;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <random>
 
@@ -8,6 +9,7 @@
 #include "Position.h"
 #include "Types.h"
 #include "game/Agent.h"
+#include "util/ObjectPool.h"
 
 namespace Game3 {
 	class Entity;
@@ -28,7 +30,7 @@ namespace Game3 {
 
 			template <typename T, typename... Args>
 			static std::shared_ptr<T> create(Game &game, Args && ...args) {
-				auto out = std::shared_ptr<T>(new T(std::forward<Args>(args)...));
+				auto out = makePooled<T>([&](void *storage) { return new (storage) T(std::forward<Args>(args)...); });
 				out->init(game);
 				return out;
 			}
@@ -38,7 +40,8 @@ namespace Game3 {
 			static std::shared_ptr<TileEntity> fromJSON(Game &, const nlohmann::json &);
 
 			virtual void init(Game &) {}
-			virtual void tick(Game &, float) {}
+			/** Tile entities that don't override this go to sleep forever after their first tick. */
+			virtual void tick(Game &, float) { sleepForever(); }
 			virtual void onSpawn() {}
 			virtual void onRemove() {}
 			virtual void onNeighborUpdated(Index /* row_offset */, Index /* column_offset */) {}
@@ -59,6 +62,17 @@ namespace Game3 {
 			/** Called when the TileEntity is destroyed violently, e.g. by a bomb. Returns false if the TileEntity should survive the destruction. */
 			virtual bool kill() { return false; }
 			inline bool is(const Identifier &check) const { return getID() == check; }
+			/** The realm time (see Realm::simulatedTime) at which the tile entity next needs to be ticked. */
+			inline double getWakeTime() const { return wakeTime; }
+			/** Skips ticks until the realm's simulated time reaches the given time. Takes effect after the current tick. */
+			void sleepUntil(double realm_time);
+			void sleepFor(double seconds);
+			/** Skips ticks until wakeUp() is called. */
+			void sleepForever();
+			/** Makes the tile entity tick again from the next tick on. */
+			void wakeUp();
+			/** Records that time-derived state is current as of now. Called by the realm when the tile entity is added. */
+			void markUpdated();
 
 		protected:
 			TileEntity() = default;
@@ -67,8 +81,16 @@ namespace Game3 {
 
 			virtual void absorbJSON(Game &, const nlohmann::json &);
 			virtual void toJSON(nlohmann::json &) const;
+			/** Seconds of realm time since markUpdated() was last called, or 0 if it never was. State that changes
+			 *  steadily over time can be derived from this when it's read instead of being advanced every tick. */
+			double getTimeSinceUpdate() const;
 
 			friend void to_json(nlohmann::json &, const TileEntity &);
+
+		private:
+			double wakeTime = 0.;
+			/** Negative if markUpdated() hasn't been called. */
+			std::atomic<double> lastUpdate = -1.;
 	};
 
 	using TileEntityPtr = std::shared_ptr<TileEntity>;
@@ -12,6 +12,7 @@ namespace Game3 {
 			constexpr static float HIVE_MATURITY = 60.f;
 			constexpr static double CHAR_CHANCE = 0.314159265358979323;
 
+			/** Both ages are as of the last update (see TileEntity::markUpdated). Use getAge() and getHiveAge() to read the current values. */
 			float age = 0.f;
 			float hiveAge = -1.f; // < 0 for no hive
 
@@ -25,9 +26,10 @@ namespace Game3 {
 			void toJSON(nlohmann::json &) const override;
 			void absorbJSON(Game &, const nlohmann::json &) override;
 			void onSpawn() override;
-			void tick(Game &, float) override;
 			bool onInteractNextTo(const PlayerPtr &) override;
 			bool hasHive() const;
+			float getAge() const;
+			float getHiveAge() const;
 			bool kill() override;
 			void render(SpriteRenderer &) override;
 
@@ -41,5 +43,7 @@ namespace Game3 {
 			Identifier immatureTilename;
 			std::optional<TileID> immatureTileID;
 			TileID getImmatureTileID(const Tileset &);
+			/** Folds the time elapsed since the last update into age and hiveAge. */
+			void catchUp();
 	};
 }
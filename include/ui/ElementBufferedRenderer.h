@@ -1,10 +1,13 @@
 #pragma once
 
+#include <array>
+#include <memory>
 #include <unordered_set>
 #include <vector>
 
 #include "Shader.h"
 #include "Types.h"
+#include "realm/RealmJournal.h"
 #include "ui/RectangleRenderer.h"
 #include "ui/Reshader.h"
 #include "util/GL.h"
@@ -29,7 +32,8 @@ namespace Game3 {
 			std::shared_ptr<Tilemap> tilemap;
 			GL::Texture lightTexture;
 
-			ElementBufferedRenderer(Realm &);
+			/** The layer is numbered from 1 to 3 and picks which of the realm's journaled tile edits this renderer uploads. */
+			ElementBufferedRenderer(Realm &, uint8_t layer);
 			~ElementBufferedRenderer();
 
 			void reset();
@@ -37,6 +41,8 @@ namespace Game3 {
 			void render(float divisor, float scale, float center_x, float center_y);
 			/** Doesn't bind any texture—the caller must bind a texture before calling this. */
 			void render(float divisor);
+			/** Regenerates the whole vertex buffer. Edits journaled by the realm are uploaded on their own before each
+			 *  render, so this is only needed for changes that bypass the journal. */
 			void reupload();
 			bool onBackbufferResized(int width, int height);
 			inline void markDirty() { dirty = true; }
@@ -58,12 +64,18 @@ namespace Game3 {
 			RectangleRenderer rectangle;
 			Reshader reshader;
 			Realm &realm;
+			uint8_t layer;
+			std::shared_ptr<RealmJournal::Cursor> journalCursor;
 			std::vector<TileID> tileCache;
 
 			void generateVertexBufferObject();
 			void generateElementBufferObject();
 			void generateVertexArrayObject();
 			void generateLightingTexture();
+			std::array<std::array<float, 3>, 4> generateTile(size_t x, size_t y) const;
+			/** Rewrites the vertices of the tiles edited since the last call, or the whole buffer if the journal dropped
+			 *  entries before they were read. */
+			void applyJournal();
 
 			void recomputeLighting();
 
@@ -113,6 +113,7 @@ namespace Game3 {
 			void newGame(size_t seed, int width, int height, const WorldGenParams &);
 			void loadGame(const std::filesystem::path &);
 			void saveGame(const std::filesystem::path &);
+			void saveGame(const std::filesystem::path &, int compression_level);
 			bool render(const Glib::RefPtr<Gdk::GLContext> &);
 			bool onKeyPressed(guint, guint, Gdk::ModifierType);
 			void onKeyReleased(guint, guint, Gdk::ModifierType);
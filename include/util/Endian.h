@@ -0,0 +1,47 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace Game3 {
+	template <typename T>
+	requires std::is_integral_v<T>
+	constexpr T swapBytes(T value) {
+		if constexpr (sizeof(T) == 1) {
+			return value;
+		} else {
+			using U = std::make_unsigned_t<T>;
+			U in = static_cast<U>(value);
+			U out = 0;
+			for (size_t i = 0; i < sizeof(T); ++i) {
+				out = static_cast<U>((out << 8) | (in & 0xff));
+				in = static_cast<U>(in >> 8);
+			}
+			return static_cast<T>(out);
+		}
+	}
+
+	/** Converts between native and little-endian byte order. The conversion is its own inverse. */
+	template <typename T>
+	constexpr T toLittle(T value) {
+		if constexpr (std::endian::native == std::endian::little)
+			return value;
+		else
+			return swapBytes(value);
+	}
+
+	template <typename T>
+	T readLittle(const void *source) {
+		T value;
+		std::memcpy(&value, source, sizeof(value));
+		return toLittle(value);
+	}
+
+	template <typename T>
+	void writeLittle(void *destination, T value) {
+		value = toLittle(value);
+		std::memcpy(destination, &value, sizeof(value));
+	}
+}
@@ -1,8 +1,30 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <string>
 
 namespace Game3 {
 	std::string readFile(const std::filesystem::path &);
+
+	/** A private, copy-on-write memory mapping of an entire file. Writes to the mapping never reach the file.
+	 *  The file must not be truncated while it's mapped; replace it with a rename instead. */
+	class MappedFile {
+		public:
+			MappedFile(const std::filesystem::path &);
+			MappedFile(const MappedFile &) = delete;
+			MappedFile(MappedFile &&) = delete;
+			~MappedFile();
+
+			MappedFile & operator=(const MappedFile &) = delete;
+			MappedFile & operator=(MappedFile &&) = delete;
+
+			inline uint8_t * data() const { return bytes; }
+			inline size_t size() const { return length; }
+
+		private:
+			uint8_t *bytes = nullptr;
+			size_t length = 0;
+	};
 }
@@ -4,6 +4,7 @@
 #include <functional>
 #include <iostream>
 #include <numeric>
+#include <vector>
 
 #define GL_GLEXT_PROTOTYPES
 #include <GL/gl.h>
@@ -115,36 +116,39 @@ namespace GL {
 		return makeBufferObject(GL_ARRAY_BUFFER, data, count, usage);
 	}
 
+	/** Appends the four vertices of the square at (x, y) in the layout used by genSquareVBO. */
+	template <typename T, size_t N>
+	inline void pushSquare(std::vector<T> &vertex_data, size_t x, size_t y, const std::array<std::array<T, N>, 4> &generated) {
+		vertex_data.push_back(x);
+		vertex_data.push_back(y);
+		for (const T item: generated[0])
+			vertex_data.push_back(item);
+
+		vertex_data.push_back(x + 1);
+		vertex_data.push_back(y);
+		for (const T item: generated[1])
+			vertex_data.push_back(item);
+
+		vertex_data.push_back(x);
+		vertex_data.push_back(y + 1);
+		for (const T item: generated[2])
+			vertex_data.push_back(item);
+
+		vertex_data.push_back(x + 1);
+		vertex_data.push_back(y + 1);
+		for (const T item: generated[3])
+			vertex_data.push_back(item);
+	}
+
+	/** Squares are stored column by column: the square at (x, y) starts at vertex 4 * (x * height + y). */
 	template <typename T, size_t N>
 	inline GLuint genSquareVBO(size_t width, size_t height, GLenum usage, const std::function<std::array<std::array<T, N>, 4>(size_t, size_t)> &fn) {
 		std::vector<T> vertex_data;
-		vertex_data.reserve(width * height * (2 + N));
-
-		for (size_t x = 0; x < width; ++x) {
-			for (size_t y = 0; y < height; ++y) {
-				const auto generated = fn(x, y);
-
-				vertex_data.push_back(x);
-				vertex_data.push_back(y);
-				for (const T item: generated[0])
-					vertex_data.push_back(item);
-
-				vertex_data.push_back(x + 1);
-				vertex_data.push_back(y);
-				for (const T item: generated[1])
-					vertex_data.push_back(item);
-
-				vertex_data.push_back(x);
-				vertex_data.push_back(y + 1);
-				for (const T item: generated[2])
-					vertex_data.push_back(item);
-
-				vertex_data.push_back(x + 1);
-				vertex_data.push_back(y + 1);
-				for (const T item: generated[3])
-					vertex_data.push_back(item);
-			}
-		}
+		vertex_data.reserve(width * height * 4 * (2 + N));
+
+		for (size_t x = 0; x < width; ++x)
+			for (size_t y = 0; y < height; ++y)
+				pushSquare<T, N>(vertex_data, x, y, fn(x, y));
 
 		return GL::makeVBO(vertex_data.data(), vertex_data.size(), usage);
 	}
@@ -198,6 +202,13 @@ namespace GL {
 				handle = genSquareVBO<T, N>(width, height, usage, fn);
 			}
 
+			/** Overwrites part of the buffer, starting at the given offset (in units of T). Leaves the buffer bound. */
+			template <typename T>
+			void update(size_t offset, const T *data, size_t count) {
+				glBindBuffer(GL_ARRAY_BUFFER, handle); CHECKGL
+				glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(T), count * sizeof(T), data); CHECKGL
+			}
+
 			~VBO() {
 				reset();
 			}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+
+namespace Game3 {
+	struct ThreadCache;
+
+	/** Hands out small fixed-size blocks carved from large slabs. Each slab serves a single size class and keeps its own
+	 *  free list. Each thread keeps a small cache of free blocks for the pool it last allocated from. It refills that
+	 *  cache from the slabs and returns blocks to them CACHE_BATCH at a time, so most allocations and frees don't take
+	 *  the pool's lock. A slab whose blocks have all been returned is released right away unless it's the last one of
+	 *  its size class. Memory is therefore bounded by the peak number of live blocks per size class, plus one slab per
+	 *  size class and whatever sits in thread caches. A pool keeps itself alive while any object made with makePooled
+	 *  still has its control block, so a pool can outlive whatever owned it. Safe to use from multiple threads. */
+	class ObjectPool: public std::enable_shared_from_this<ObjectPool> {
+		public:
+			/** Block sizes are rounded up to a multiple of this, which is also the alignment of every block. */
+			constexpr static size_t GRANULARITY = 16;
+			/** Larger allocations go straight to operator new. */
+			constexpr static size_t MAX_BLOCK_SIZE = 1024;
+			/** Slabs are aligned to their size so that a block's slab can be found from its address. */
+			constexpr static size_t SLAB_SIZE = 64 * 1024;
+			/** How many blocks a thread cache takes from or gives back to the slabs at once. A cache holds at most twice
+			 *  this many blocks per size class. */
+			constexpr static size_t CACHE_BATCH = 32;
+
+			/** Sets the pool used by makePooled on the current thread until the scope ends. */
+			class Scope {
+				public:
+					explicit Scope(std::shared_ptr<ObjectPool>);
+					~Scope();
+
+					Scope(const Scope &) = delete;
+					Scope & operator=(const Scope &) = delete;
+
+				private:
+					std::shared_ptr<ObjectPool> pool;
+					ObjectPool *previous;
+			};
+
+			ObjectPool();
+			~ObjectPool();
+
+			ObjectPool(const ObjectPool &) = delete;
+			ObjectPool(ObjectPool &&) = delete;
+			ObjectPool & operator=(const ObjectPool &) = delete;
+			ObjectPool & operator=(ObjectPool &&) = delete;
+
+			void * allocate(size_t size, size_t alignment);
+			void deallocate(void *, size_t size, size_t alignment) noexcept;
+
+			/** Keeps the pool alive until a matching unpin(), without the caller having to hold a reference to it. The
+			 *  pool must already be owned by a shared_ptr. */
+			void pin();
+			/** May destroy the pool, so the caller must not touch it afterward. */
+			void unpin() noexcept;
+
+			/** The pool used on threads that haven't set one with a Scope. */
+			static const std::shared_ptr<ObjectPool> & getDefault();
+			/** The pool used by makePooled on this thread. Doesn't take a reference: the pool stays alive at least as long
+			 *  as the Scope that set it. */
+			static ObjectPool & getCurrent();
+
+		private:
+			constexpr static size_t SIZE_CLASS_COUNT = MAX_BLOCK_SIZE / GRANULARITY;
+
+			struct FreeBlock {
+				FreeBlock *next;
+			};
+
+			/** Stored at the start of each slab. */
+			struct Slab {
+				/** Neighbors in the list of every slab in the pool. */
+				Slab *previous = nullptr;
+				Slab *next = nullptr;
+				/** Neighbors in the size class's list of slabs with free blocks. */
+				Slab *previousPartial = nullptr;
+				Slab *nextPartial = nullptr;
+				FreeBlock *freeList = nullptr;
+				/** The part of the slab that hasn't been carved into blocks yet. */
+				std::byte *unused = nullptr;
+				/** Blocks that are out of the slab, including ones sitting in thread caches. */
+				size_t used = 0;
+				size_t sizeClass = 0;
+				bool partial = false;
+			};
+
+			struct SizeClass {
+				Slab *partial = nullptr;
+				size_t slabCount = 0;
+			};
+
+			constexpr static size_t SLAB_HEADER_SIZE = (sizeof(Slab) + GRANULARITY - 1) / GRANULARITY * GRANULARITY;
+
+			/** Distinguishes pools in thread caches, even ones that reuse the address of a destroyed pool. */
+			const uint64_t id;
+			std::mutex mutex;
+			std::array<SizeClass, SIZE_CLASS_COUNT> sizeClasses;
+			Slab *slabs = nullptr;
+			std::atomic<size_t> pinCount = 0;
+			/** Set while pinCount is nonzero. Guarded by the mutex. */
+			std::shared_ptr<ObjectPool> self;
+
+			/** Moves up to count blocks of the size class onto the front of the list and returns how many were moved. */
+			size_t takeBlocks(size_t size_class, FreeBlock *&list, size_t count);
+			/** Gives back a list of blocks of one size class. */
+			void returnBlocks(FreeBlock *list);
+			/** Assumes the mutex is locked. */
+			void returnBlock(FreeBlock *);
+			Slab * makeSlab(size_t size_class);
+			/** Assumes the mutex is locked. */
+			void releaseSlab(Slab *);
+			void addPartial(Slab *);
+			void removePartial(Slab *);
+
+			static inline bool isPooled(size_t size, size_t alignment) {
+				return size <= MAX_BLOCK_SIZE && alignment <= GRANULARITY;
+			}
+
+			static inline size_t getSizeClass(size_t size) {
+				return (std::max<size_t>(size, 1) + GRANULARITY - 1) / GRANULARITY - 1;
+			}
+
+			static inline Slab * getSlab(const void *block) {
+				return reinterpret_cast<Slab *>(reinterpret_cast<uintptr_t>(block) & ~(SLAB_SIZE - 1));
+			}
+
+			friend struct ThreadCache;
+	};
+
+	/** Lets shared_ptr put its control blocks in an ObjectPool. Every allocation pins the pool until it's deallocated.
+	 *  Since a control block is the last thing of a pooled object to be freed, that keeps the pool alive for as long as
+	 *  anything refers to the object, even weakly. */
+	template <typename T>
+	class PoolAllocator {
+		public:
+			using value_type = T;
+
+			ObjectPool *pool;
+
+			explicit PoolAllocator(ObjectPool &pool_): pool(&pool_) {}
+
+			template <typename U>
+			PoolAllocator(const PoolAllocator<U> &other): pool(other.pool) {}
+
+			T * allocate(size_t count) {
+				T *pointer = static_cast<T *>(pool->allocate(count * sizeof(T), alignof(T)));
+				pool->pin();
+				return pointer;
+			}
+
+			void deallocate(T *pointer, size_t count) noexcept {
+				ObjectPool *const unpinned = pool;
+				unpinned->deallocate(pointer, count * sizeof(T), alignof(T));
+				unpinned->unpin();
+			}
+
+			template <typename U>
+			bool operator==(const PoolAllocator<U> &other) const { return pool == other.pool; }
+	};
+
+	/** Doesn't need to keep the pool alive itself: the object's control block, allocated with a PoolAllocator, outlives
+	 *  the deleter's call. */
+	template <typename T>
+	struct PoolDeleter {
+		ObjectPool *pool;
+
+		void operator()(T *object) const noexcept {
+			object->~T();
+			pool->deallocate(object, sizeof(T), alignof(T));
+		}
+	};
+
+	/** Makes a shared T whose storage and control block both come from the current thread's pool. The factory gets
+	 *  storage for one T and must return the result of a placement new into it. Calling the constructor from a lambda
+	 *  lets classes with non-public constructors be pooled from their own create functions. */
+	template <typename T, typename F>
+	std::shared_ptr<T> makePooled(F &&factory) {
+		ObjectPool &pool = ObjectPool::getCurrent();
+		void *storage = pool.allocate(sizeof(T), alignof(T));
+		T *object = nullptr;
+		try {
+			object = factory(storage);
+		} catch (...) {
+			pool.deallocate(storage, sizeof(T), alignof(T));
+			throw;
+		}
+		return std::shared_ptr<T>(object, PoolDeleter<T>{&pool}, PoolAllocator<T>(pool));
+	}
+}
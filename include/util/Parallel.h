@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Game3 {
+	/** Calls the function with every index in [0, count) using up to one thread per core.
+	 *  Rethrows the first exception thrown by the function after all threads have stopped.
+	 *  A single index, or a single core, is handled on the calling thread without starting any threads. */
+	template <typename F>
+	void parallelFor(size_t count, F &&function) {
+		if (count <= 1 || std::thread::hardware_concurrency() <= 1) {
+			for (size_t index = 0; index < count; ++index)
+				function(index);
+			return;
+		}
+
+		const size_t thread_count = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+		std::atomic_size_t next = 0;
+		std::exception_ptr error;
+		std::mutex error_mutex;
+
+		std::vector<std::thread> threads;
+		threads.reserve(thread_count);
+
+		for (size_t i = 0; i < thread_count; ++i)
+			threads.emplace_back([&] {
+				try {
+					for (size_t index; (index = next++) < count;)
+						function(index);
+				} catch (...) {
+					std::unique_lock lock(error_mutex);
+					if (!error)
+						error = std::current_exception();
+					next = count;
+				}
+			});
+
+		for (auto &thread: threads)
+			thread.join();
+
+		if (error)
+			std::rethrow_exception(error);
+	}
+}
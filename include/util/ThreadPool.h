@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Game3 {
+	/** A fixed set of worker threads for work that happens every tick, where starting new threads each time
+	 *  (as parallelFor does) would cost more than the work itself. */
+	class ThreadPool {
+		public:
+			/** A thread count of 0 means one thread per core. The calling thread also does work, so one fewer worker is started. */
+			explicit ThreadPool(size_t thread_count = 0);
+			~ThreadPool();
+
+			ThreadPool(const ThreadPool &) = delete;
+			ThreadPool(ThreadPool &&) = delete;
+			ThreadPool & operator=(const ThreadPool &) = delete;
+			ThreadPool & operator=(ThreadPool &&) = delete;
+
+			/** Calls the function with every index in [0, count) and waits for all of them to finish. Rethrows the first
+			 *  exception thrown by the function. Not reentrant: the function mustn't call run on the same pool. */
+			void run(size_t count, const std::function<void(size_t)> &);
+			inline size_t getThreadCount() const { return workers.size() + 1; }
+
+		private:
+			std::vector<std::thread> workers;
+			std::mutex mutex;
+			std::condition_variable workReady;
+			std::condition_variable workDone;
+			const std::function<void(size_t)> *job = nullptr;
+			size_t jobCount = 0;
+			std::atomic_size_t next = 0;
+			/** Incremented for each call to run so that workers can tell a new job from the one they just finished. */
+			size_t generation = 0;
+			size_t busyWorkers = 0;
+			std::exception_ptr error;
+			bool stopping = false;
+
+			void work();
+			void drain(const std::function<void(size_t)> &, size_t count);
+	};
+}
@@ -12,6 +12,8 @@
 namespace Game3 {
 	static constexpr GLint DEFAULT_FILTER = GL_NEAREST;
 
+	bool Texture::headless = false;
+
 	Texture::Texture():
 		NamedRegisterable(Identifier()) {}
 
@@ -23,6 +25,15 @@ namespace Game3 {
 		path(path_) {}
 
 	void Texture::init() {
+		if (headless) {
+			if (*width == 0) {
+				int channels = 0;
+				if (stbi_info(path.c_str(), width.get(), height.get(), &channels) == 0)
+					throw std::runtime_error("Couldn't read image dimensions from " + path.string());
+			}
+			return;
+		}
+
 		if (!*valid_) {
 			int channels = 0;
 			uint8_t *raw = stbi_load(path.c_str(), width.get(), height.get(), &channels, 0);
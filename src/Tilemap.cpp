@@ -1,19 +1,27 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+
 #include <zstd.h>
 
 #include "Tilemap.h"
 #include "Tileset.h"
 #include "container/Quadtree.h"
 #include "game/Game.h"
+#include "util/Endian.h"
+#include "util/FS.h"
+#include "util/Parallel.h"
+#include "util/Util.h"
 
 namespace Game3 {
 	Tilemap::Tilemap(int width_, int height_, int tile_size, int set_width, int set_height, std::shared_ptr<Tileset> tileset_):
 	width(width_), height(height_), tileSize(tile_size), textureName(tileset_->getTextureName()), setWidth(set_width), setHeight(set_height), tileset(std::move(tileset_)) {
-		tiles.resize(width * height);
+		initChunks();
 	}
 
 	Tilemap::Tilemap(int width_, int height_, int tile_size, std::shared_ptr<Tileset> tileset_):
 	width(width_), height(height_), tileSize(tile_size), textureName(tileset_->getTextureName()), tileset(std::move(tileset_)) {
-		tiles.resize(width * height);
+		initChunks();
 	}
 
 	void Tilemap::init(const Game &game) {
@@ -30,6 +38,12 @@ namespace Game3 {
 
 	Tilemap::~Tilemap() = default;
 
+	void Tilemap::initChunks() {
+		chunksWide = updiv<Index>(width, TileChunk::SIZE);
+		chunksHigh = updiv<Index>(height, TileChunk::SIZE);
+		chunks.assign(chunksWide * chunksHigh, TileChunk());
+	}
+
 	std::shared_ptr<Texture> Tilemap::getTexture(const Game &game) {
 		if (texture)
 			return texture;
@@ -45,18 +59,70 @@ namespace Game3 {
 	}
 
 	void Tilemap::set(Index index, TileID value) {
-		auto &tile = tiles[index];
+		const Index x = index % width;
+		const Index y = index / width;
+		auto &chunk = getChunk(x, y);
+		const size_t chunk_index = getChunkIndex(x, y);
 		if (lavaQuadtree) {
+			const TileID tile = chunk[chunk_index];
 			if (value == lavaID && tile != lavaID)
-				lavaQuadtree->add(index / width, index % width);
+				lavaQuadtree->add(y, x);
 			else if (value != lavaID && tile == lavaID)
-				lavaQuadtree->remove(index / width, index % width);
+				lavaQuadtree->remove(y, x);
+		}
+		chunk.set(chunk_index, value);
+	}
+
+	void Tilemap::setUnsafe(Index index, TileID value) {
+		const Index x = index % width;
+		const Index y = index / width;
+		getChunk(x, y).set(getChunkIndex(x, y), value);
+	}
+
+	void Tilemap::updateLava(const std::vector<Index> &indices) {
+		if (!lavaQuadtree || indices.empty())
+			return;
+
+		if (size() / 4 <= indices.size()) {
+			lavaQuadtree->absorb();
+			return;
+		}
+
+		for (const Index index: indices) {
+			const Index x = index % width;
+			const Index y = index / width;
+			if ((*this)(x, y) == lavaID)
+				lavaQuadtree->add(y, x);
+			else
+				lavaQuadtree->remove(y, x);
+		}
+	}
+
+	void Tilemap::setLayout(TileLayout new_layout) {
+		if (new_layout == layout)
+			return;
+
+		const auto &old_spread = *spread;
+		const auto &new_spread = TileChunk::getSpread(new_layout);
+		std::array<TileID, TileChunk::AREA> old_tiles, new_tiles;
+
+		for (auto &chunk: chunks) {
+			if (chunk.isUniform())
+				continue;
+			chunk.copyTo(old_tiles.data());
+			for (Index y = 0; y < TileChunk::SIZE; ++y)
+				for (Index x = 0; x < TileChunk::SIZE; ++x)
+					new_tiles[new_spread.x[x] | new_spread.y[y]] = old_tiles[old_spread.x[x] | old_spread.y[y]];
+			chunk.assign(new_tiles.data());
 		}
-		tile = value;
+
+		layout = new_layout;
+		spread = &new_spread;
 	}
 
 	void Tilemap::reset(TileID value) {
-		tiles.assign(tiles.size(), value);
+		for (auto &chunk: chunks)
+			chunk.fill(value);
 		if (lavaQuadtree) {
 			lavaQuadtree->reset();
 			if (lavaID && *lavaID == value)
@@ -64,64 +130,387 @@ namespace Game3 {
 		}
 	}
 
+	void Tilemap::compact() {
+		for (auto &chunk: chunks)
+			chunk.compact();
+	}
+
+	std::vector<TileID> Tilemap::getTiles() const {
+		std::vector<TileID> out(size());
+		std::array<TileID, TileChunk::AREA> buffer;
+		for (Index chunk_y = 0; chunk_y < chunksHigh; ++chunk_y) {
+			for (Index chunk_x = 0; chunk_x < chunksWide; ++chunk_x) {
+				chunks[chunk_x + chunk_y * chunksWide].copyTo(buffer.data());
+				const Index x_min = chunk_x * TileChunk::SIZE;
+				const Index y_min = chunk_y * TileChunk::SIZE;
+				const Index x_max = std::min<Index>(width, x_min + TileChunk::SIZE);
+				const Index y_max = std::min<Index>(height, y_min + TileChunk::SIZE);
+				for (Index y = y_min; y < y_max; ++y)
+					for (Index x = x_min; x < x_max; ++x)
+						out[x + y * width] = buffer[getChunkIndex(x, y)];
+			}
+		}
+		return out;
+	}
+
+	void Tilemap::setTiles(const std::vector<TileID> &new_tiles) {
+		if (new_tiles.size() != size())
+			throw std::invalid_argument("Tile count doesn't match tilemap size");
+		std::array<TileID, TileChunk::AREA> buffer;
+		for (Index chunk_y = 0; chunk_y < chunksHigh; ++chunk_y) {
+			for (Index chunk_x = 0; chunk_x < chunksWide; ++chunk_x) {
+				const Index x_min = chunk_x * TileChunk::SIZE;
+				const Index y_min = chunk_y * TileChunk::SIZE;
+				const Index x_max = std::min<Index>(width, x_min + TileChunk::SIZE);
+				const Index y_max = std::min<Index>(height, y_min + TileChunk::SIZE);
+				// Parts of edge chunks that lie outside the map are padded with zeroes.
+				buffer.fill(0);
+				for (Index y = y_min; y < y_max; ++y)
+					for (Index x = x_min; x < x_max; ++x)
+						buffer[getChunkIndex(x, y)] = new_tiles[x + y * width];
+				chunks[chunk_x + chunk_y * chunksWide].assign(buffer.data());
+			}
+		}
+	}
+
 	std::vector<Index> Tilemap::getLand(Index right_pad, Index bottom_pad) const {
 		std::vector<Index> land_tiles;
 		land_tiles.reserve(width * height);
-		for (Index row = 0; row < height - bottom_pad; ++row)
-			for (Index column = 0; column < width - right_pad; ++column)
-				if (tileset->isLand(tiles[row * width + column]))
-					land_tiles.push_back(row * width + column);
+		const Index max_column = width - right_pad;
+		for (Index row = 0; row < height - bottom_pad; ++row) {
+			for (Index column = 0; column < max_column;) {
+				const auto &chunk = getChunk(column, row);
+				// Whole rows of uniform chunks can be judged at once.
+				const Index chunk_end = std::min(max_column, (column | TileChunk::MASK) + 1);
+				if (chunk.isUniform()) {
+					if (tileset->isLand(chunk.getUniformValue()))
+						for (; column < chunk_end; ++column)
+							land_tiles.push_back(row * width + column);
+					column = chunk_end;
+					continue;
+				}
+				for (; column < chunk_end; ++column)
+					if (tileset->isLand(chunk[getChunkIndex(column, row)]))
+						land_tiles.push_back(row * width + column);
+			}
+		}
 		return land_tiles;
 	}
 
-	void to_json(nlohmann::json &json, const Tilemap &tilemap) {
-		json["height"] = tilemap.height;
-		json["setHeight"] = tilemap.setHeight;
-		json["setWidth"] = tilemap.setWidth;
-		json["tileSize"] = tilemap.tileSize;
-		json["width"] = tilemap.width;
-		json["tileset"] = tilemap.tileset->identifier;
-
-		// TODO: fix endianness issues
-		const auto tiles_size = tilemap.size() * sizeof(tilemap[0]);
-		const auto buffer_size = ZSTD_compressBound(tiles_size);
-		auto buffer = std::vector<uint8_t>(buffer_size);
-		auto result = ZSTD_compress(&buffer[0], buffer_size, tilemap.data(), tiles_size, ZSTD_maxCLevel());
-		if (ZSTD_isError(result))
-			throw std::runtime_error("Couldn't compress tiles");
-		buffer.resize(result);
-		json["tiles"] = std::move(buffer);
+	std::vector<size_t> Tilemap::getRegionChunks(Index region_x, Index region_y) const {
+		std::vector<size_t> out;
+		out.reserve(REGION_CHUNKS * REGION_CHUNKS);
+		const Index x_max = std::min(chunksWide, (region_x + 1) * REGION_CHUNKS);
+		const Index y_max = std::min(chunksHigh, (region_y + 1) * REGION_CHUNKS);
+		for (Index chunk_y = region_y * REGION_CHUNKS; chunk_y < y_max; ++chunk_y)
+			for (Index chunk_x = region_x * REGION_CHUNKS; chunk_x < x_max; ++chunk_x)
+				out.push_back(chunk_x + chunk_y * chunksWide);
+		return out;
 	}
 
-	Tilemap Tilemap::fromJSON(const Game &game, const nlohmann::json &json) {
-		auto tileset = game.registry<TilesetRegistry>()[json.at("tileset").get<Identifier>()];
-		Tilemap tilemap(json.at("height"), json.at("width"), json.at("tileSize"), json.at("setWidth"), json.at("setHeight"), tileset);
+	// A serialized region consists of a (bits, palette size) pair of uint16s for each chunk, where the palette size is replaced
+	// with the tile ID if the chunk is uniform, followed by all the chunks' palettes, followed by the packed words of all the
+	// chunks, starting at the next multiple of 8 bytes. Everything is little-endian.
+
+	std::vector<uint8_t> Tilemap::encodeRegion(Index region_x, Index region_y) const {
+		std::vector<uint16_t> header;
+		size_t word_count = 0;
+
+		const auto chunk_indices = getRegionChunks(region_x, region_y);
+
+		for (const size_t chunk_index: chunk_indices) {
+			const auto &chunk = chunks[chunk_index];
+			header.push_back(chunk.getBits());
+			if (chunk.isUniform()) {
+				header.push_back(chunk.getUniformValue());
+			} else {
+				header.push_back(static_cast<uint16_t>(chunk.getPalette().size()));
+				word_count += TileChunk::getWordCount(chunk.getBits());
+			}
+		}
+
+		for (const size_t chunk_index: chunk_indices) {
+			const auto &palette = chunks[chunk_index].getPalette();
+			header.insert(header.end(), palette.begin(), palette.end());
+		}
+
+		const size_t words_offset = alignBlob(header.size() * sizeof(uint16_t));
+		std::vector<uint8_t> out(words_offset + word_count * sizeof(uint64_t));
+		for (size_t i = 0; i < header.size(); ++i)
+			writeLittle(&out[i * sizeof(uint16_t)], header[i]);
+
+		uint8_t *words = out.data() + words_offset;
+		for (const size_t chunk_index: chunk_indices) {
+			const auto &chunk = chunks[chunk_index];
+			if (!chunk.isUniform()) {
+				const uint64_t *chunk_words = chunk.getWords();
+				for (size_t i = 0, max = TileChunk::getWordCount(chunk.getBits()); i < max; ++i) {
+					writeLittle(words, chunk_words[i]);
+					words += sizeof(uint64_t);
+				}
+			}
+		}
+
+		return out;
+	}
+
+	void Tilemap::decodeRegion(Index region_x, Index region_y, const std::shared_ptr<uint64_t[]> &buffer, size_t size) {
+		auto *bytes = reinterpret_cast<uint8_t *>(buffer.get());
+
+		auto read = [&](size_t offset) -> uint16_t {
+			if (size < offset + sizeof(uint16_t))
+				throw std::runtime_error("Tile region is truncated");
+			return readLittle<uint16_t>(bytes + offset);
+		};
+
+		const auto chunk_indices = getRegionChunks(region_x, region_y);
+		size_t palette_offset = chunk_indices.size() * 2 * sizeof(uint16_t);
+		size_t palette_total = 0;
+
+		for (size_t i = 0; i < chunk_indices.size(); ++i)
+			if (read(i * 2 * sizeof(uint16_t)) != 0)
+				palette_total += read((i * 2 + 1) * sizeof(uint16_t));
+
+		size_t words_offset = alignBlob(palette_offset + palette_total * sizeof(uint16_t));
+
+		for (size_t i = 0; i < chunk_indices.size(); ++i) {
+			const uint16_t bits  = read(i * 2 * sizeof(uint16_t));
+			const uint16_t value = read((i * 2 + 1) * sizeof(uint16_t));
+			auto &chunk = chunks[chunk_indices[i]];
+
+			if (bits == 0) {
+				chunk.fill(value);
+				continue;
+			}
 
-		// TODO: fix endianness issues
-		tilemap.tiles.clear();
-		const size_t out_size = ZSTD_DStreamOutSize();
-		std::vector<uint8_t> out_buffer(out_size);
-		std::vector<uint8_t> bytes = json.at("tiles");
+			if (TileChunk::RAW_BITS < bits)
+				throw std::runtime_error("Invalid tile chunk bit width: " + std::to_string(bits));
 
-		auto context = std::unique_ptr<ZSTD_DCtx, size_t(*)(ZSTD_DCtx *)>(ZSTD_createDCtx(), ZSTD_freeDCtx);
-		auto stream = std::unique_ptr<ZSTD_DStream, size_t(*)(ZSTD_DStream *)>(ZSTD_createDStream(), ZSTD_freeDStream);
+			std::vector<TileID> palette(value);
+			for (auto &tile: palette) {
+				tile = read(palette_offset);
+				palette_offset += sizeof(uint16_t);
+			}
 
-		ZSTD_inBuffer input {bytes.data(), bytes.size(), 0};
+			const size_t word_count = TileChunk::getWordCount(static_cast<uint8_t>(bits));
+			if (size < words_offset + word_count * sizeof(uint64_t))
+				throw std::runtime_error("Tile region is truncated");
 
-		size_t last_result = 0;
+			uint64_t *words = buffer.get() + words_offset / sizeof(uint64_t);
+			if constexpr (std::endian::native != std::endian::little)
+				for (size_t word = 0; word < word_count; ++word)
+					words[word] = toLittle(words[word]);
 
-		while (input.pos < input.size) {
-			ZSTD_outBuffer output {&out_buffer[0], out_size, 0};
-			const size_t result = ZSTD_decompressStream(stream.get(), &output, &input);
-			if (ZSTD_isError(result))
-				throw std::runtime_error("Couldn't decompress tiles");
-			last_result = result;
-			const TileID *raw_tiles = reinterpret_cast<const TileID *>(out_buffer.data());
-			tilemap.tiles.insert(tilemap.tiles.end(), raw_tiles, raw_tiles + output.pos / sizeof(TileID));
+			chunk.adopt(static_cast<uint8_t>(bits), std::move(palette), std::shared_ptr<uint64_t[]>(buffer, words));
+			words_offset += word_count * sizeof(uint64_t);
 		}
+	}
+
+	// A blob starts with a header:
+	//    0  "G3TM"
+	//    4  uint16 version
+	//    6  uint16 chunk size
+	//    8  uint16 region size in chunks
+	//   10  uint16 layout of tiles within chunks (0 = row-major, 1 = Morton)
+	//   12  uint32 width
+	//   16  uint32 height
+	//   20  uint32 tile size
+	//   24   int32 set width
+	//   28   int32 set height
+	//   32  uint32 region count
+	//   36  uint32 length of the tileset identifier
+	//   40  tileset identifier
+	// That's followed, at the next multiple of 8 bytes, by a table with an entry for each region in row-major order:
+	//    0  uint64 offset of the region from the start of the blob
+	//    8  uint32 stored size
+	//   12  uint32 uncompressed size
+	// A region is stored uncompressed if and only if both sizes are equal. Regions start at multiples of 8 bytes.
+	// Everything is little-endian.
+
+	namespace {
+		constexpr char BLOB_MAGIC[4] {'G', '3', 'T', 'M'};
+		constexpr uint16_t BLOB_VERSION = 1;
+		constexpr size_t BLOB_HEADER_SIZE = 40;
+		constexpr size_t BLOB_TABLE_ENTRY_SIZE = 16;
+	}
+
+	std::vector<uint8_t> Tilemap::toBlob(int compression_level) const {
+		const Index regions_x = updiv(chunksWide, REGION_CHUNKS);
+		const Index regions_y = updiv(chunksHigh, REGION_CHUNKS);
+		const size_t region_count = regions_x * regions_y;
+		const std::string tileset_name = tileset->identifier.str();
+
+		std::vector<std::vector<uint8_t>> regions(region_count);
+		std::vector<uint32_t> raw_sizes(region_count);
+
+		parallelFor(region_count, [&](size_t region_index) {
+			static thread_local auto context = std::unique_ptr<ZSTD_CCtx, size_t(*)(ZSTD_CCtx *)>(ZSTD_createCCtx(), ZSTD_freeCCtx);
+			auto raw = encodeRegion(region_index % regions_x, region_index / regions_x);
+			raw_sizes[region_index] = static_cast<uint32_t>(raw.size());
+
+			if (compression_level != UNCOMPRESSED) {
+				auto &buffer = regions[region_index];
+				buffer.resize(ZSTD_compressBound(raw.size()));
+				const size_t result = ZSTD_compressCCtx(context.get(), buffer.data(), buffer.size(), raw.data(), raw.size(), compression_level);
+				if (ZSTD_isError(result))
+					throw std::runtime_error("Couldn't compress tiles: " + std::string(ZSTD_getErrorName(result)));
+				// Keep the compressed version only if it's actually smaller; equal sizes would look uncompressed.
+				if (result < raw.size()) {
+					buffer.resize(result);
+					return;
+				}
+			}
+
+			regions[region_index] = std::move(raw);
+		});
+
+		const size_t table_offset = alignBlob(BLOB_HEADER_SIZE + tileset_name.size());
+		size_t size = alignBlob(table_offset + region_count * BLOB_TABLE_ENTRY_SIZE);
+		std::vector<size_t> offsets(region_count);
+		for (size_t i = 0; i < region_count; ++i) {
+			offsets[i] = size;
+			size = alignBlob(size + regions[i].size());
+		}
+
+		std::vector<uint8_t> out(size);
+		uint8_t *data = out.data();
+		std::memcpy(data, BLOB_MAGIC, sizeof(BLOB_MAGIC));
+		writeLittle<uint16_t>(data + 4, BLOB_VERSION);
+		writeLittle<uint16_t>(data + 6, TileChunk::SIZE);
+		writeLittle<uint16_t>(data + 8, REGION_CHUNKS);
+		writeLittle<uint16_t>(data + 10, static_cast<uint16_t>(layout));
+		writeLittle<uint32_t>(data + 12, width);
+		writeLittle<uint32_t>(data + 16, height);
+		writeLittle<uint32_t>(data + 20, tileSize);
+		writeLittle<int32_t>(data + 24, setWidth);
+		writeLittle<int32_t>(data + 28, setHeight);
+		writeLittle<uint32_t>(data + 32, static_cast<uint32_t>(region_count));
+		writeLittle<uint32_t>(data + 36, static_cast<uint32_t>(tileset_name.size()));
+		std::memcpy(data + BLOB_HEADER_SIZE, tileset_name.data(), tileset_name.size());
+
+		for (size_t i = 0; i < region_count; ++i) {
+			uint8_t *entry = data + table_offset + i * BLOB_TABLE_ENTRY_SIZE;
+			writeLittle<uint64_t>(entry, offsets[i]);
+			writeLittle<uint32_t>(entry + 8, static_cast<uint32_t>(regions[i].size()));
+			writeLittle<uint32_t>(entry + 12, raw_sizes[i]);
+			std::memcpy(data + offsets[i], regions[i].data(), regions[i].size());
+		}
+
+		return out;
+	}
+
+	Tilemap Tilemap::fromBlob(const Game &game, const uint8_t *data, size_t size, const std::shared_ptr<void> &owner) {
+		if (size < BLOB_HEADER_SIZE || std::memcmp(data, BLOB_MAGIC, sizeof(BLOB_MAGIC)) != 0)
+			throw std::runtime_error("Invalid tile blob");
+
+		if (const auto version = readLittle<uint16_t>(data + 4); version != BLOB_VERSION)
+			throw std::runtime_error("Unsupported tile blob version: " + std::to_string(version));
+
+		if (readLittle<uint16_t>(data + 6) != TileChunk::SIZE || readLittle<uint16_t>(data + 8) != REGION_CHUNKS)
+			throw std::runtime_error("Unsupported tile chunk or region size");
+
+		const size_t tileset_name_size = readLittle<uint32_t>(data + 36);
+		if (size < BLOB_HEADER_SIZE + tileset_name_size)
+			throw std::runtime_error("Tile blob is truncated");
+
+		const Identifier tileset_name(std::string_view(reinterpret_cast<const char *>(data + BLOB_HEADER_SIZE), tileset_name_size));
+		auto tileset = game.registry<TilesetRegistry>()[tileset_name];
+		Tilemap tilemap(readLittle<uint32_t>(data + 12), readLittle<uint32_t>(data + 16), readLittle<uint32_t>(data + 20), readLittle<int32_t>(data + 24), readLittle<int32_t>(data + 28), tileset);
+		// The chunks are all still uniform, so there's nothing to reorder.
+		tilemap.layout = static_cast<TileLayout>(readLittle<uint16_t>(data + 10));
+		tilemap.spread = &TileChunk::getSpread(tilemap.layout);
+
+		const Index regions_x = updiv(tilemap.chunksWide, REGION_CHUNKS);
+		const Index regions_y = updiv(tilemap.chunksHigh, REGION_CHUNKS);
+		const size_t region_count = readLittle<uint32_t>(data + 32);
+		if (region_count != static_cast<size_t>(regions_x * regions_y))
+			throw std::runtime_error("Wrong number of tile regions");
+
+		const size_t table_offset = alignBlob(BLOB_HEADER_SIZE + tileset_name_size);
+		if (size < table_offset + region_count * BLOB_TABLE_ENTRY_SIZE)
+			throw std::runtime_error("Tile blob is truncated");
+
+		// Bitwidth and palette size for each chunk, the largest possible palettes and raw 16-bit words.
+		constexpr size_t max_region_size = REGION_CHUNKS * REGION_CHUNKS * (2 * sizeof(uint16_t) + 256 * sizeof(TileID) + TileChunk::AREA * sizeof(TileID)) + sizeof(uint64_t);
 
-		if (last_result != 0)
-			throw std::runtime_error("Reached end of tile input without finishing decompression");
+		parallelFor(region_count, [&](size_t region_index) {
+			static thread_local auto context = std::unique_ptr<ZSTD_DCtx, size_t(*)(ZSTD_DCtx *)>(ZSTD_createDCtx(), ZSTD_freeDCtx);
+			const uint8_t *entry = data + table_offset + region_index * BLOB_TABLE_ENTRY_SIZE;
+			const size_t offset      = readLittle<uint64_t>(entry);
+			const size_t stored_size = readLittle<uint32_t>(entry + 8);
+			const size_t raw_size    = readLittle<uint32_t>(entry + 12);
+
+			if (size < offset || size - offset < stored_size || max_region_size < raw_size)
+				throw std::runtime_error("Invalid tile region");
+
+			const uint8_t *region = data + offset;
+			std::shared_ptr<uint64_t[]> buffer;
+
+			if (stored_size == raw_size) {
+				const bool aligned = reinterpret_cast<uintptr_t>(region) % alignof(uint64_t) == 0;
+				if (owner && aligned && std::endian::native == std::endian::little) {
+					// The region can be used in place, which also keeps the owner alive for as long as any chunk still refers to it.
+					buffer = std::shared_ptr<uint64_t[]>(owner, reinterpret_cast<uint64_t *>(const_cast<uint8_t *>(region)));
+				} else {
+					buffer = std::shared_ptr<uint64_t[]>(new uint64_t[updiv(raw_size, sizeof(uint64_t))]);
+					std::memcpy(buffer.get(), region, raw_size);
+				}
+			} else {
+				buffer = std::shared_ptr<uint64_t[]>(new uint64_t[updiv(raw_size, sizeof(uint64_t))]);
+				const size_t result = ZSTD_decompressDCtx(context.get(), buffer.get(), raw_size, region, stored_size);
+				if (ZSTD_isError(result))
+					throw std::runtime_error("Couldn't decompress tiles: " + std::string(ZSTD_getErrorName(result)));
+				if (result != raw_size)
+					throw std::runtime_error("Decompressed tile region is the wrong size");
+			}
+
+			tilemap.decodeRegion(region_index % regions_x, region_index / regions_x, buffer, raw_size);
+		});
+
+		if (tilemap.lavaQuadtree)
+			tilemap.lavaQuadtree->absorb();
+
+		return tilemap;
+	}
+
+	void Tilemap::toJSON(nlohmann::json &json, int compression_level) const {
+		json["blob"] = nlohmann::json::binary(toBlob(compression_level));
+	}
+
+	void to_json(nlohmann::json &json, const Tilemap &tilemap) {
+		tilemap.toJSON(json);
+	}
+
+	Tilemap Tilemap::fromJSON(const Game &game, const nlohmann::json &json) {
+		if (json.contains("blob")) {
+			const auto &blob = json.at("blob").get_binary();
+			return fromBlob(game, blob.data(), blob.size());
+		}
+
+		if (json.contains("blobOffset")) {
+			// The blob was hoisted out of the document by writeSave and lives in the memory-mapped save file.
+			const auto &mapping = game.mappedSave;
+			if (!mapping)
+				throw std::runtime_error("Tilemap refers to a save file that isn't mapped");
+			const size_t offset = json.at("blobOffset");
+			const size_t size = json.at("blobSize");
+			if (mapping->size() < offset || mapping->size() - offset < size)
+				throw std::runtime_error("Tile blob lies outside of the save file");
+			return fromBlob(game, mapping->data() + offset, size, mapping);
+		}
+
+		// Older saves compress the entire layer as one native-endian frame of row-major tiles.
+		auto tileset = game.registry<TilesetRegistry>()[json.at("tileset").get<Identifier>()];
+		Tilemap tilemap(json.at("width"), json.at("height"), json.at("tileSize"), json.at("setWidth"), json.at("setHeight"), tileset);
+
+		std::vector<TileID> tiles(tilemap.size());
+		const std::vector<uint8_t> bytes = json.at("tiles");
+		const size_t result = ZSTD_decompress(tiles.data(), tiles.size() * sizeof(TileID), bytes.data(), bytes.size());
+		if (ZSTD_isError(result))
+			throw std::runtime_error("Couldn't decompress tiles: " + std::string(ZSTD_getErrorName(result)));
+		if (result != tiles.size() * sizeof(TileID))
+			throw std::runtime_error("Decompressed tile data is the wrong size");
+		tilemap.setTiles(tiles);
 
 		if (tilemap.lavaQuadtree)
 			tilemap.lavaQuadtree->absorb();
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "Tileset.h"
 #include "game/Game.h"
 #include "item/Item.h"
@@ -11,26 +13,14 @@ namespace Game3 {
 		return land.contains(id);
 	}
 
-	bool Tileset::isLand(TileID id) const {
-		return isLand(names.at(id));
-	}
-
 	bool Tileset::isWalkable(const Identifier &id) const {
 		return land.contains(id) || walkable.contains(id) || !solid.contains(id);
 	}
 
-	bool Tileset::isWalkable(TileID id) const {
-		return isWalkable(names.at(id));
-	}
-
 	bool Tileset::isSolid(const Identifier &id) const {
 		return solid.contains(id);
 	}
 
-	bool Tileset::isSolid(TileID id) const {
-		return isSolid(names.at(id));
-	}
-
 	const Identifier & Tileset::getEmpty() const {
 		return empty;
 	}
@@ -85,53 +75,31 @@ namespace Game3 {
 		return false;
 	}
 
-	bool Tileset::isMarchable(TileID id) {
-		if (marchableCache.contains(id))
-			return true;
-
-		if (unmarchableCache.contains(id))
-			return false;
-
-		const auto &tilename = names.at(id);
-
-		if (marchable.contains(tilename)) {
-			marchableCache.insert(id);
-			return true;
-		}
-
-		for (const auto &category: inverseCategories.at(tilename)) {
-			if (marchable.contains(category)) {
-				marchableCache.insert(id);
-				return true;
-			}
-		}
-
-		unmarchableCache.insert(id);
-		return false;
-	}
-
 	bool Tileset::isCategoryMarchable(const Identifier &category) const {
 		return marchable.contains(category);
 	}
 
 	void Tileset::clearCache() {
-		marchableCache.clear();
-		unmarchableCache.clear();
 		brightCache.reset();
 	}
 
-	const std::set<Identifier> Tileset::getCategories(const Identifier &tilename) const {
+	const std::set<Identifier> & Tileset::getCategories(const Identifier &tilename) const {
 		return inverseCategories.at(tilename);
 	}
 
-	const std::set<TileID> Tileset::getCategoryIDs(const Identifier &category) const {
-		std::set<TileID> out;
-		for (const auto &tilename: categories.at(category))
-			out.insert((*this)[tilename]);
-		return out;
+	const std::vector<TileCategoryPtr> & Tileset::getCategories(TileID id) const {
+		return tileCategories.at(id);
+	}
+
+	const TileCategory & Tileset::getCategory(const Identifier &category) const {
+		return *categoryTables.at(category);
 	}
 
-	const std::set<Identifier> Tileset::getTilesByCategory(const Identifier &category) const {
+	const std::vector<TileID> & Tileset::getCategoryIDs(const Identifier &category) const {
+		return getCategory(category).getIDs();
+	}
+
+	const std::set<Identifier> & Tileset::getTilesByCategory(const Identifier &category) const {
 		return categories.at(category);
 	}
 
@@ -141,6 +109,12 @@ namespace Game3 {
 		return false;
 	}
 
+	bool Tileset::isInCategory(TileID id, const Identifier &category) const {
+		if (auto iter = categoryTables.find(category); iter != categoryTables.end())
+			return iter->second->contains(id);
+		return false;
+	}
+
 	bool Tileset::hasName(const Identifier &tilename) const {
 		return ids.contains(tilename);
 	}
@@ -188,6 +162,54 @@ namespace Game3 {
 			for (const auto &tilename: set)
 				tileset.inverseCategories[tilename].insert(category);
 
+		tileset.buildTables();
 		return tileset;
 	}
+
+	void Tileset::buildTables() {
+		const size_t id_count = names.empty()? 0 : size_t(names.rbegin()->first) + 1;
+		tileFlags.assign(id_count, 0);
+		tileCategories.assign(id_count, {});
+		categoryTables.clear();
+
+		for (const auto &[category_name, tilenames]: categories) {
+			auto category = std::make_shared<TileCategory>();
+			category->name = category_name;
+			category->marchable = marchable.contains(category_name);
+			category->bits.assign((id_count + 63) / 64, 0);
+			for (const auto &tilename: tilenames) {
+				auto iter = ids.find(tilename);
+				if (iter == ids.end())
+					continue;
+				const TileID id = iter->second;
+				category->bits[id / 64] |= uint64_t(1) << (id % 64);
+				category->ids.push_back(id);
+			}
+			std::sort(category->ids.begin(), category->ids.end());
+			category->ids.erase(std::unique(category->ids.begin(), category->ids.end()), category->ids.end());
+			categoryTables.emplace(category_name, category);
+		}
+
+		for (const auto &[id, tilename]: names) {
+			uint8_t flags = 0;
+			if (isLand(tilename))
+				flags |= LAND;
+			if (isWalkable(tilename))
+				flags |= WALKABLE;
+			if (isSolid(tilename))
+				flags |= SOLID;
+			if (marchable.contains(tilename))
+				flags |= MARCHABLE;
+
+			auto &tile_categories = tileCategories[id];
+			for (const auto &category_name: inverseCategories.at(tilename)) {
+				const auto &category = categoryTables.at(category_name);
+				if (category->marchable)
+					flags |= MARCHABLE;
+				tile_categories.push_back(category);
+			}
+
+			tileFlags[id] = flags;
+		}
+	}
 }
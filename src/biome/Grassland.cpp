@@ -34,7 +34,7 @@ namespace Game3 {
 		const auto wetness    = params.wetness;
 		const auto stoneLevel = params.stoneLevel;
 
-		auto &layer1  = realm.tilemap1->getTilesUnsafe();
+		auto &layer1  = *realm.tilemap1;
 		auto &tileset = *realm.tilemap1->tileset;
 		const Index index = realm.getIndex(row, column);
 
@@ -51,24 +51,24 @@ namespace Game3 {
 		static const Identifier forest_floor  = "base:tile/forest_floor"_id;
 
 		if (noise < wetness) {
-			layer1[index] = tileset[deeper_water];
+			layer1.setUnsafe(index, tileset[deeper_water]);
 		} else if (noise < wetness + 0.1) {
-			layer1[index] = tileset[deep_water];
+			layer1.setUnsafe(index, tileset[deep_water]);
 		} else if (noise < wetness + 0.2) {
-			layer1[index] = tileset[water];
+			layer1.setUnsafe(index, tileset[water]);
 		} else if (noise < wetness + 0.3) {
-			layer1[index] = tileset[shallow_water];
+			layer1.setUnsafe(index, tileset[shallow_water]);
 		} else if (noise < wetness + 0.4) {
-			layer1[index] = tileset[sand];
+			layer1.setUnsafe(index, tileset[sand]);
 		} else if (noise < wetness + 0.5) {
-			layer1[index] = tileset[light_grass];
+			layer1.setUnsafe(index, tileset[light_grass]);
 		} else if (stoneLevel < noise) {
-			layer1[index] = tileset[stone];
+			layer1.setUnsafe(index, tileset[stone]);
 		} else {
 			if (std::uniform_int_distribution(0, 15)(rng) == 0)
-				layer1[index] = tileset[choose(tileset.getTilesByCategory("base:category/small_flowers"), rng)];
+				layer1.setUnsafe(index, tileset[choose(tileset.getTilesByCategory("base:category/small_flowers"), rng)]);
 			else
-				layer1[index] = tileset[choose(grasses, rng)];
+				layer1.setUnsafe(index, tileset[choose(grasses, rng)]);
 			const double forest_noise = forestPerlin->GetValue(row / Biome::NOISE_ZOOM, column / Biome::NOISE_ZOOM, 0.5);
 			if (params.forestThreshold < forest_noise) {
 				uint8_t mod = column % 2;
@@ -79,7 +79,7 @@ namespace Game3 {
 					static const std::vector<Identifier> trees {"base:tile/tree1"_id, "base:tile/tree2"_id, "base:tile/tree3"_id};
 					realm.add(TileEntity::create<Tree>(realm.getGame(), choose(trees, rng), "base:tile/tree0"_id, Position(row, column), Tree::MATURITY));
 				}
-				layer1[index] = tileset[forest_floor];
+				layer1.setUnsafe(index, tileset[forest_floor]);
 			}
 		}
 	}
@@ -21,7 +21,7 @@ namespace Game3 {
 		const auto wetness    = params.wetness;
 		const auto stoneLevel = params.stoneLevel;
 
-		auto &layer1  = realm.tilemap1->getTilesUnsafe();
+		auto &layer1  = *realm.tilemap1;
 		auto &tileset = *realm.tilemap1->tileset;
 		const Index index = realm.getIndex(row, column);
 
@@ -39,23 +39,23 @@ namespace Game3 {
 		static const Identifier stone         = "base:tile/stone"_id;
 
 		if (noise < wetness) {
-			layer1[index] = tileset[deeper_water];
+			layer1.setUnsafe(index, tileset[deeper_water]);
 		} else if (noise < wetness + 0.1) {
-			layer1[index] = tileset[deep_water];
+			layer1.setUnsafe(index, tileset[deep_water]);
 		} else if (noise < wetness + 0.2) {
-			layer1[index] = tileset[water];
+			layer1.setUnsafe(index, tileset[water]);
 		} else if (noise < wetness + 0.3) {
-			layer1[index] = tileset[shallow_water];
+			layer1.setUnsafe(index, tileset[shallow_water]);
 		} else if (noise < wetness + 0.39) {
-			layer1[index] = tileset[sand];
+			layer1.setUnsafe(index, tileset[sand]);
 		} else if (noise < wetness + 0.42) {
-			layer1[index] = tileset[dark_ice];
+			layer1.setUnsafe(index, tileset[dark_ice]);
 		} else if (noise < wetness + 0.5) {
-			layer1[index] = tileset[light_ice];
+			layer1.setUnsafe(index, tileset[light_ice]);
 		} else if (stoneLevel < noise) {
-			layer1[index] = tileset[stone];
+			layer1.setUnsafe(index, tileset[stone]);
 		} else {
-			layer1[index] = tileset[snow];
+			layer1.setUnsafe(index, tileset[snow]);
 			const double forest_noise = forestPerlin->GetValue(row / Biome::NOISE_ZOOM, column / Biome::NOISE_ZOOM, 0.5);
 			if (params.forestThreshold < forest_noise) {
 				uint8_t mod = column % 2;
@@ -17,7 +17,7 @@ namespace Game3 {
 		Realm &realm = *getRealm();
 		const auto wetness = params.wetness;
 
-		auto &layer1  = realm.tilemap1->getTilesUnsafe();
+		auto &layer1  = *realm.tilemap1;
 		auto &tileset = *realm.tilemap1->tileset;
 		const Index index = realm.getIndex(row, column);
 
@@ -33,19 +33,19 @@ namespace Game3 {
 		static const Identifier volcanic_rock = "base:tile/volcanic_rock"_id;
 
 		if (noise < wetness) {
-			layer1[index] = tileset[deeper_water];
+			layer1.setUnsafe(index, tileset[deeper_water]);
 		} else if (noise < wetness + 0.1) {
-			layer1[index] = tileset[deep_water];
+			layer1.setUnsafe(index, tileset[deep_water]);
 		} else if (noise < wetness + 0.2) {
-			layer1[index] = tileset[water];
+			layer1.setUnsafe(index, tileset[water]);
 		} else if (noise < wetness + 0.3) {
-			layer1[index] = tileset[shallow_water];
+			layer1.setUnsafe(index, tileset[shallow_water]);
 		} else if (noise < wetness + 0.4) {
-			layer1[index] = tileset[volcanic_sand];
+			layer1.setUnsafe(index, tileset[volcanic_sand]);
 		} else if (0.85 < noise) {
-			layer1[index] = tileset[lava];
+			layer1.setUnsafe(index, tileset[lava]);
 		} else {
-			layer1[index] = tileset[volcanic_rock];
+			layer1.setUnsafe(index, tileset[volcanic_rock]);
 		}
 	}
 
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+
+#include "container/TileChunk.h"
+
+namespace Game3 {
+	namespace {
+		uint8_t getBitsForPalette(size_t palette_size) {
+			if (palette_size <= 2)
+				return 1;
+			if (palette_size <= 4)
+				return 2;
+			if (palette_size <= 16)
+				return 4;
+			if (palette_size <= 256)
+				return 8;
+			return TileChunk::RAW_BITS;
+		}
+
+		std::shared_ptr<uint64_t[]> allocateWords(uint8_t bits) {
+			const size_t count = TileChunk::getWordCount(bits);
+			std::shared_ptr<uint64_t[]> words(new uint64_t[count]);
+			std::fill(words.get(), words.get() + count, 0);
+			return words;
+		}
+
+		constexpr TileChunk::Spread makeSpread(TileLayout layout) {
+			TileChunk::Spread out {};
+			for (Index i = 0; i < TileChunk::SIZE; ++i) {
+				if (layout == TileLayout::RowMajor) {
+					out.x[i] = static_cast<uint16_t>(i);
+					out.y[i] = static_cast<uint16_t>(i << TileChunk::SHIFT);
+				} else {
+					uint16_t spread = 0;
+					for (Index bit = 0; bit < TileChunk::SHIFT; ++bit)
+						if ((i >> bit) & 1)
+							spread |= 1 << (2 * bit);
+					out.x[i] = spread;
+					out.y[i] = static_cast<uint16_t>(spread << 1);
+				}
+			}
+			return out;
+		}
+
+		constexpr TileChunk::Spread ROW_MAJOR_SPREAD = makeSpread(TileLayout::RowMajor);
+		constexpr TileChunk::Spread MORTON_SPREAD    = makeSpread(TileLayout::Morton);
+	}
+
+	const TileChunk::Spread & TileChunk::getSpread(TileLayout layout) {
+		switch (layout) {
+			case TileLayout::RowMajor: return ROW_MAJOR_SPREAD;
+			case TileLayout::Morton:   return MORTON_SPREAD;
+			default:
+				throw std::invalid_argument("Invalid tile layout: " + std::to_string(static_cast<int>(layout)));
+		}
+	}
+
+	void TileChunk::set(size_t index, TileID value) {
+		uint64_t packed = value;
+
+		if (bits != RAW_BITS) {
+			if (bits == 0) {
+				if (value == uniformValue)
+					return;
+				palette.assign(1, uniformValue);
+				repack(1);
+			}
+
+			if (auto iter = std::find(palette.begin(), palette.end(), value); iter != palette.end()) {
+				packed = iter - palette.begin();
+			} else {
+				if (palette.size() == (size_t(1) << bits))
+					repack(bits == 8? RAW_BITS : bits * 2);
+				if (bits != RAW_BITS) {
+					packed = palette.size();
+					palette.push_back(value);
+				}
+			}
+		}
+
+		write(index, packed);
+	}
+
+	void TileChunk::fill(TileID value) {
+		bits = 0;
+		palette.clear();
+		words.reset();
+		uniformValue = value;
+	}
+
+	void TileChunk::assign(const TileID *source) {
+		std::vector<TileID> new_palette;
+		std::array<uint16_t, AREA> indices;
+		uint16_t last_index = 0;
+
+		for (Index i = 0; i < AREA; ++i) {
+			const TileID tile = source[i];
+			if (i == 0 || tile != source[i - 1]) {
+				auto iter = std::find(new_palette.begin(), new_palette.end(), tile);
+				if (iter == new_palette.end()) {
+					new_palette.push_back(tile);
+					iter = new_palette.end() - 1;
+				}
+				last_index = static_cast<uint16_t>(iter - new_palette.begin());
+			}
+			indices[i] = last_index;
+		}
+
+		if (new_palette.size() == 1) {
+			fill(new_palette.front());
+			return;
+		}
+
+		bits = getBitsForPalette(new_palette.size());
+		words = allocateWords(bits);
+
+		if (bits == RAW_BITS) {
+			palette.clear();
+			for (Index i = 0; i < AREA; ++i)
+				write(i, source[i]);
+		} else {
+			palette = std::move(new_palette);
+			for (Index i = 0; i < AREA; ++i)
+				write(i, indices[i]);
+		}
+	}
+
+	void TileChunk::adopt(uint8_t bits_, std::vector<TileID> palette_, std::shared_ptr<uint64_t[]> words_) {
+		if (bits_ != 1 && bits_ != 2 && bits_ != 4 && bits_ != 8 && bits_ != RAW_BITS)
+			throw std::invalid_argument("Invalid tile chunk bit width: " + std::to_string(bits_));
+		if (bits_ == RAW_BITS? !palette_.empty() : (palette_.empty() || (size_t(1) << bits_) < palette_.size()))
+			throw std::invalid_argument("Invalid tile chunk palette size: " + std::to_string(palette_.size()));
+		if (!words_)
+			throw std::invalid_argument("Tile chunk words are missing");
+
+		bits = bits_;
+		palette = std::move(palette_);
+		words = std::move(words_);
+	}
+
+	void TileChunk::copyTo(TileID *out) const {
+		if (bits == 0) {
+			std::fill(out, out + AREA, uniformValue);
+			return;
+		}
+
+		for (Index i = 0; i < AREA; ++i)
+			out[i] = (*this)[i];
+	}
+
+	bool TileChunk::compact() {
+		if (bits == 0)
+			return true;
+
+		std::array<TileID, AREA> tiles;
+		copyTo(tiles.data());
+		assign(tiles.data());
+		return bits == 0;
+	}
+
+	void TileChunk::write(size_t index, uint64_t packed) {
+		const size_t bit = index * bits;
+		const uint64_t mask = ((uint64_t(1) << bits) - 1) << (bit % 64);
+		const uint64_t shifted = packed << (bit % 64);
+		if ((words[bit / 64] & mask) == shifted)
+			return;
+		if (1 < words.use_count())
+			unshare();
+		words[bit / 64] = (words[bit / 64] & ~mask) | shifted;
+	}
+
+	void TileChunk::repack(uint8_t new_bits) {
+		std::array<uint16_t, AREA> packed;
+
+		if (bits == 0) {
+			packed.fill(0);
+		} else {
+			const uint64_t mask = (uint64_t(1) << bits) - 1;
+			for (Index i = 0; i < AREA; ++i) {
+				const size_t bit = i * bits;
+				packed[i] = static_cast<uint16_t>((words[bit / 64] >> (bit % 64)) & mask);
+			}
+		}
+
+		if (new_bits == RAW_BITS) {
+			for (auto &value: packed)
+				value = palette[value];
+			palette.clear();
+		}
+
+		bits = new_bits;
+		words = allocateWords(bits);
+		for (Index i = 0; i < AREA; ++i)
+			write(i, packed[i]);
+	}
+
+	void TileChunk::unshare() {
+		const size_t count = getWordCount(bits);
+		std::shared_ptr<uint64_t[]> new_words(new uint64_t[count]);
+		std::copy(words.get(), words.get() + count, new_words.get());
+		words = std::move(new_words);
+	}
+}
@@ -1,18 +1,129 @@
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
 #include "data/Identifier.h"
 
 namespace Game3 {
+	namespace {
+		/** Interned identifiers are stored in fixed-size blocks that never move, so the strings for a handle can be read
+		 *  without locking. Only interning new identifiers takes the lock. */
+		class IdentifierTable {
+			public:
+				struct Entry {
+					std::string combined;
+					std::string space;
+					std::string name;
+				};
+
+				IdentifierTable() {
+					append("", "");
+				}
+
+				~IdentifierTable() {
+					for (auto &block: blocks)
+						delete[] block.load(std::memory_order_relaxed);
+				}
+
+				Identifier::Handle intern(std::string_view space, std::string_view name) {
+					std::string combined;
+					combined.reserve(space.size() + 1 + name.size());
+					combined.append(space).append(1, ':').append(name);
+
+					{
+						std::shared_lock lock(mutex);
+						if (auto iter = handles.find(combined); iter != handles.end())
+							return iter->second;
+					}
+
+					std::unique_lock lock(mutex);
+					if (auto iter = handles.find(combined); iter != handles.end())
+						return iter->second;
+					return append(space, name);
+				}
+
+				const Entry & operator[](Identifier::Handle handle) const {
+					return blocks[handle >> BLOCK_SHIFT].load(std::memory_order_acquire)[handle & BLOCK_MASK];
+				}
+
+			private:
+				constexpr static size_t BLOCK_SHIFT = 12;
+				constexpr static size_t BLOCK_SIZE  = size_t(1) << BLOCK_SHIFT;
+				constexpr static size_t BLOCK_MASK  = BLOCK_SIZE - 1;
+				constexpr static size_t MAX_BLOCKS  = 1024;
+
+				std::array<std::atomic<Entry *>, MAX_BLOCKS> blocks {};
+				/** Keys point into the entries' combined strings. */
+				std::unordered_map<std::string_view, Identifier::Handle> handles;
+				size_t count = 0;
+				std::shared_mutex mutex;
+
+				/** Must be called with the mutex held exclusively (or from the constructor). */
+				Identifier::Handle append(std::string_view space, std::string_view name) {
+					if (MAX_BLOCKS * BLOCK_SIZE <= count)
+						throw std::length_error("Too many identifiers");
+
+					Entry *block = blocks[count >> BLOCK_SHIFT].load(std::memory_order_relaxed);
+					if (!block) {
+						block = new Entry[BLOCK_SIZE];
+						blocks[count >> BLOCK_SHIFT].store(block, std::memory_order_release);
+					}
+
+					Entry &entry = block[count & BLOCK_MASK];
+					entry.space = space;
+					entry.name = name;
+					entry.combined.reserve(space.size() + 1 + name.size());
+					entry.combined.append(space).append(1, ':').append(name);
+
+					const auto handle = static_cast<Identifier::Handle>(count++);
+					handles.emplace(entry.combined, handle);
+					return handle;
+				}
+		};
+
+		IdentifierTable & getTable() {
+			static IdentifierTable table;
+			return table;
+		}
+	}
+
+	Identifier::Identifier(std::string_view space_, std::string_view name_) {
+		if (space_.find(':') != std::string_view::npos)
+			throw std::invalid_argument("Identifier space can't contain a colon: " + std::string(space_));
+		if (!space_.empty() || !name_.empty())
+			handle = getTable().intern(space_, name_);
+	}
+
 	Identifier::Identifier(std::string_view combined) {
 		const size_t colon = combined.find(':');
 		if (colon == std::string_view::npos)
 			throw std::invalid_argument("Not a valid identifier: " + std::string(combined));
-		space = std::string(combined.substr(0, colon));
-		name  = std::string(combined.substr(colon + 1));
+		handle = getTable().intern(combined.substr(0, colon), combined.substr(colon + 1));
 	}
 
 	Identifier::Identifier(const char *combined):
 		Identifier(std::string_view(combined)) {}
 
+	Identifier::Identifier(const std::string &combined):
+		Identifier(std::string_view(combined)) {}
+
+	const std::string & Identifier::str() const {
+		return getTable()[handle].combined;
+	}
+
+	const std::string & Identifier::getSpace() const {
+		return getTable()[handle].space;
+	}
+
+	const std::string & Identifier::getName() const {
+		return getTable()[handle].name;
+	}
+
 	std::string Identifier::getPath() const {
+		const auto &name = getName();
 		const auto slash = name.find_last_of('/');
 		if (slash == name.npos)
 			return "";
@@ -20,6 +131,7 @@ namespace Game3 {
 	}
 
 	std::string Identifier::getPathStart() const {
+		const auto &name = getName();
 		const auto slash = name.find('/');
 		if (slash == name.npos)
 			return "";
@@ -27,21 +139,28 @@ namespace Game3 {
 	}
 
 	std::string Identifier::getPostPath() const {
+		const auto &name = getName();
 		const auto slash = name.find_last_of('/');
 		if (slash == name.npos)
 			return name;
 		return name.substr(slash + 1);
 	}
 
-	bool Identifier::operator==(std::string_view combined) const {
-		const size_t colon = combined.find(':');
-		if (colon == std::string_view::npos)
-			return false;
-		return space == combined.substr(0, colon) && name == combined.substr(colon + 1);
+	std::strong_ordering Identifier::operator<=>(const Identifier &other) const {
+		if (handle == other.handle)
+			return std::strong_ordering::equal;
+		const auto &entry = getTable()[handle];
+		const auto &other_entry = getTable()[other.handle];
+		if (auto comparison = entry.space <=> other_entry.space; comparison != 0)
+			return comparison;
+		return entry.name <=> other_entry.name;
 	}
 
-	bool Identifier::operator==(const Identifier &other) const {
-		return this == &other || (space == other.space && name == other.name);
+	bool Identifier::operator==(std::string_view combined) const {
+		// Without a colon, the default-constructed identifier would otherwise match an empty string.
+		if (combined.find(':') == std::string_view::npos)
+			return false;
+		return std::string_view(str()) == combined;
 	}
 
 	void from_json(const nlohmann::json &json, Identifier &identifier) {
@@ -51,10 +170,6 @@ namespace Game3 {
 	void to_json(nlohmann::json &json, const Identifier &identifier) {
 		json = identifier.str();
 	}
-
-	Identifier operator""_id(const char *string, size_t) {
-		return Identifier(string);
-	}
 }
 
 std::ostream & operator<<(std::ostream &os, const Game3::Identifier &id) {
@@ -31,13 +31,27 @@ namespace Game3 {
 			wander();
 	}
 
+	void Animal::catchUp(Game &game, float delta) {
+		Entity::catchUp(game, delta);
+
+		if ((timeUntilWander -= delta) <= 0.f)
+			wander();
+	}
+
 	bool Animal::wander() {
 		timeUntilWander = getWanderDistribution()(threadContext.rng);
 		Realm &realm = *getRealm();
 		const auto [row, column] = position;
-		return pathfind({
-			std::uniform_int_distribution(std::max(0_idx, row    - wanderRadius), std::min(realm.getHeight() - 1, row    + wanderRadius))(threadContext.rng),
-			std::uniform_int_distribution(std::max(0_idx, column - wanderRadius), std::min(realm.getWidth()  - 1, column + wanderRadius))(threadContext.rng)
-		});
+		std::uniform_int_distribution row_distribution(std::max(0_idx, row - wanderRadius), std::min(realm.getHeight() - 1, row + wanderRadius));
+		std::uniform_int_distribution column_distribution(std::max(0_idx, column - wanderRadius), std::min(realm.getWidth() - 1, column + wanderRadius));
+
+		// Rerolling unreachable targets is cheap, so animals near water or trees don't spend most wanders standing still.
+		for (int attempt = 0; attempt < WANDER_ATTEMPTS; ++attempt) {
+			const Position goal(row_distribution(threadContext.rng), column_distribution(threadContext.rng));
+			if (realm.isReachable(position, goal))
+				return pathfind(goal);
+		}
+
+		return false;
 	}
 }
@@ -26,7 +26,7 @@ namespace Game3 {
 		Entity(ID()), Worker(ID(), overworld_realm, house_realm, std::move(house_position), std::move(keep_)), Merchant(ID()) {}
 
 	std::shared_ptr<Blacksmith> Blacksmith::create(Game &game, RealmID overworld_realm, RealmID house_realm, Position house_position, std::shared_ptr<Building> keep_) {
-		auto out = std::shared_ptr<Blacksmith>(new Blacksmith(overworld_realm, house_realm, std::move(house_position), std::move(keep_)));
+		auto out = makePooled<Blacksmith>([&](void *storage) { return new (storage) Blacksmith(overworld_realm, house_realm, std::move(house_position), std::move(keep_)); });
 		out->init(game);
 		return out;
 	}
@@ -58,7 +58,7 @@ namespace Game3 {
 		if (phase != 10) {
 			player->showText("Sorry, I'm not selling anything right now.", "Blacksmith");
 		} else {
-			auto &window = getRealm()->getGame().canvas.window;
+			auto &window = getRealm()->getGame().canvas->window;
 			auto &tab    = *window.merchantTab;
 			player->queueForMove([player, &tab](const auto &) {
 				tab.hide();
@@ -150,6 +150,9 @@ namespace Game3 {
 	}
 
 	void Blacksmith::buyResources() {
+		// This changes the keep's money and stockpile, and the keep's realm might be ticking on another thread.
+		if (Realm::isTickingInParallel())
+			return Realm::deferShared([self = std::dynamic_pointer_cast<Blacksmith>(shared_from_this())] { self->buyResources(); });
 		auto &keep_realm = dynamic_cast<Keep &>(*keep->getInnerRealm());
 
 		actionTime = 0.f;
@@ -198,6 +201,9 @@ namespace Game3 {
 	}
 
 	void Blacksmith::goToForge() {
+		// The teleport into the house only happens once no realm is ticking in parallel, and this checks that it happened.
+		if (Realm::isTickingInParallel())
+			return Realm::deferShared([self = std::dynamic_pointer_cast<Blacksmith>(shared_from_this())] { self->goToForge(); });
 		auto house = std::dynamic_pointer_cast<Building>(getRealm()->tileEntityAt(housePosition));
 		if (!house)
 			throw std::runtime_error("Blacksmith couldn't find house");
@@ -7,6 +7,7 @@
 #include "entity/EntityFactory.h"
 #include "game/Game.h"
 #include "game/Inventory.h"
+#include "realm/MovementSystem.h"
 #include "realm/Realm.h"
 #include "registry/Registries.h"
 #include "ui/Canvas.h"
@@ -52,32 +53,86 @@ namespace Game3 {
 		if (json.contains("inventory"))
 			inventory = std::make_shared<Inventory>(Inventory::fromJSON(game, json.at("inventory"), shared_from_this()));
 		if (json.contains("path"))
-			path = json.at("path").get<std::list<Direction>>();
+			setPath(json.at("path").get<std::list<Direction>>());
 		if (json.contains("money"))
 			money = json.at("money");
 	}
 
-	void Entity::tick(Game &, float delta) {
+	void Entity::tick(Game &, float) {
+		// The path is followed and the offset eased by the realm's MovementSystem after all its entities have ticked.
+	}
+
+	void Entity::catchUp(Game &, float delta) {
+		for (auto steps = static_cast<size_t>(delta * getSpeed()); 0 < steps && !path.empty() && move(path.front()); --steps)
+			path.pop_front();
+		onPathChanged();
+		setOffset({0.f, 0.f});
+	}
+
+	void Entity::followPath() {
 		if (!path.empty() && move(path.front()))
 			path.pop_front();
-		auto &x = offset.x();
-		auto &y = offset.y();
-		const float speed = getSpeed();
-		if (x < 0.f)
-			x = std::min(x + delta * speed, 0.f);
-		else if (0.f < x)
-			x = std::max(x - delta * speed, 0.f);
-		if (y < 0.f)
-			y = std::min(y + delta * speed, 0.f);
-		else if (0.f < y)
-			y = std::max(y - delta * speed, 0.f);
+		onPathChanged();
+	}
+
+	void Entity::setPath(std::list<Direction> new_path) {
+		path = std::move(new_path);
+		onPathChanged();
+	}
+
+	void Entity::clearPath() {
+		path.clear();
+		onPathChanged();
+	}
+
+	void Entity::onPathChanged() {
+		if (movementSystem != nullptr)
+			movementSystem->updatePath(*this);
+	}
+
+	Eigen::Vector2f Entity::advanceOffset(float seconds) const {
+		const float distance = seconds * getSpeed();
+		const Eigen::Vector2f offset = getOffset();
+		auto approach = [distance](float value) {
+			if (value < 0.f)
+				return std::min(value + distance, 0.f);
+			if (0.f < value)
+				return std::max(value - distance, 0.f);
+			return value;
+		};
+		return {approach(offset.x()), approach(offset.y())};
+	}
+
+	Eigen::Vector2f Entity::getOffset() const {
+		if (movementSystem == nullptr)
+			return {0.f, 0.f};
+		return movementSystem->getOffset(movementSlot);
+	}
+
+	void Entity::setOffset(const Eigen::Vector2f &offset) {
+		if (movementSystem != nullptr)
+			movementSystem->setOffset(movementSlot, offset);
+	}
+
+	void Entity::onSpeedChanged() {
+		if (movementSystem != nullptr)
+			movementSystem->updateSpeed(*this);
+	}
+
+	Eigen::Vector2f Entity::getRenderOffset() const {
+		const Eigen::Vector2f offset = getOffset();
+		if (offset.x() == 0.f && offset.y() == 0.f)
+			return offset;
+		if (auto realm = weakRealm.lock())
+			return advanceOffset(realm->getGame().getTimeSinceTick());
+		return offset;
 	}
 
 	void Entity::remove() {
 		auto realm = getRealm();
 		// I'm assuming this has to be in its own variable to prevent the destructor from being called before this function returns.
 		auto shared = shared_from_this();
-		realm->entities.erase(shared);
+		realm->remove(shared);
 	}
 
 	void Entity::init(Game &game_) {
@@ -98,13 +153,14 @@ namespace Game3 {
 
 		float x_offset = 0.f;
 		float y_offset = 0.f;
-		if (offset.x() != 0.f || offset.y() != 0.f) {
+		if (const Eigen::Vector2f offset = getOffset(); offset.x() != 0.f || offset.y() != 0.f) {
+			const auto milliseconds = static_cast<int64_t>(getRealm()->getGame().getTotalSeconds() * 1000.);
 			switch (variety) {
 				case 3:
-					x_offset = 8.f * ((std::chrono::duration_cast<std::chrono::milliseconds>(getTime() - getRealm()->getGame().startTime).count() / 200) % 4);
+					x_offset = 8.f * ((milliseconds / 200) % 4);
 					break;
 				default:
-					x_offset = 8.f * ((std::chrono::duration_cast<std::chrono::milliseconds>(getTime() - getRealm()->getGame().startTime).count() / 100) % 5);
+					x_offset = 8.f * ((milliseconds / 100) % 5);
 			}
 		}
 
@@ -118,9 +174,10 @@ namespace Game3 {
 				break;
 		}
 
+		const Eigen::Vector2f render_offset = getRenderOffset();
 		sprite_renderer(*texture, {
-			.x = position.column + offset.x(),
-			.y = position.row + offset.y(),
+			.x = position.column + render_offset.x(),
+			.y = position.row + render_offset.y(),
 			.x_offset = x_offset,
 			.y_offset = y_offset,
 			.size_x = 16.f,
@@ -164,6 +221,7 @@ namespace Game3 {
 				throw std::invalid_argument("Invalid direction: " + std::to_string(int(move_direction)));
 		}
 
+		Eigen::Vector2f offset = getOffset();
 		if ((horizontal && offset.x() != 0) || (!horizontal && offset.y() != 0))
 			return false;
 
@@ -173,6 +231,7 @@ namespace Game3 {
 				offset.x() = x_offset;
 			else
 				offset.y() = y_offset;
+			setOffset(offset);
 			return true;
 		}
 
@@ -212,6 +271,9 @@ namespace Game3 {
 		if (realm->getHeight() <= new_position.row || realm->getWidth() <= new_position.column)
 			return false;
 
+		if (realm->hasCells())
+			return realm->getCell(new_position).isPassable();
+
 		const auto &tileset = *realm->tilemap1->tileset;
 
 		if (!tileset.isWalkable((*realm->tilemap1)[new_position]))
@@ -243,8 +305,9 @@ namespace Game3 {
 		canvas.autofocusCounter = 0;
 		const auto &tilemap = *realm->tilemap1;
 		constexpr bool adjust = false; // Render-to-texture silliness
-		canvas.center.x() = -(getColumn() - tilemap.width  / 2.f + 0.5f) - offset.x();
-		canvas.center.y() = -(getRow()    - tilemap.height / 2.f + 0.5f) - offset.y();
+		const Eigen::Vector2f render_offset = getRenderOffset();
+		canvas.center.x() = -(getColumn() - tilemap.width  / 2.f + 0.5f) - render_offset.x();
+		canvas.center.y() = -(getRow()    - tilemap.height / 2.f + 0.5f) - render_offset.y();
 		if (adjust) {
 			canvas.center.x() -= canvas.width()  / 32.f / canvas.scale;
 			canvas.center.y() += canvas.height() / 32.f / canvas.scale;
@@ -252,11 +315,12 @@ namespace Game3 {
 	}
 
 	void Entity::teleport(const Position &new_position, bool clear_offset) {
+		const Position old_position = position;
 		position = new_position;
 		if (clear_offset)
-			offset = {0.f, 0.f};
+			setOffset({0.f, 0.f});
 		auto shared = shared_from_this();
-		getRealm()->onMoved(shared, new_position);
+		getRealm()->onMoved(shared, old_position, new_position);
 		for (auto iter = moveQueue.begin(); iter != moveQueue.end();) {
 			if ((*iter)(shared))
 				moveQueue.erase(iter++);
@@ -266,9 +330,15 @@ namespace Game3 {
 	}
 
 	void Entity::teleport(const Position &new_position, const std::shared_ptr<Realm> &new_realm) {
+		// Moving between realms changes both of them, and either might be ticking on another thread.
+		if (Realm::isTickingInParallel())
+			return Realm::deferShared([self = shared_from_this(), new_position, new_realm] { self->teleport(new_position, new_realm); });
 		auto old_realm = getRealm();
 		auto shared = shared_from_this();
 		old_realm->queueRemoval(shared);
+		// The new realm files the entity in its grid and journal under the position it has when it's added, and the old
+		// position means nothing there.
+		position = new_position;
 		new_realm->add(shared);
 		teleport(new_position);
 	}
@@ -303,6 +373,9 @@ namespace Game3 {
 		if (start == goal)
 			return true;
 
+		if (!getRealm()->isReachable(start, goal))
+			return false;
+
 		if (!simpleAStar(getRealm(), start, goal, positions))
 			return false;
 
@@ -330,7 +403,9 @@ namespace Game3 {
 	}
 
 	bool Entity::pathfind(const Position &goal) {
-		return pathfind(position, goal, path);
+		const bool found = pathfind(position, goal, path);
+		onPathChanged();
+		return found;
 	}
 
 	Game & Entity::getGame() {
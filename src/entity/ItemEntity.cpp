@@ -31,7 +31,7 @@ namespace Game3 {
 	}
 
 	std::shared_ptr<ItemEntity> ItemEntity::create(Game &game, const ItemStack &stack) {
-		auto out = std::shared_ptr<ItemEntity>(std::unique_ptr<ItemEntity>(new ItemEntity(stack)));
+		auto out = makePooled<ItemEntity>([&](void *storage) { return new (storage) ItemEntity(stack); });
 		out->init(game);
 		return out;
 	}
@@ -61,6 +61,7 @@ namespace Game3 {
 				return;
 		}
 
+		const Eigen::Vector2f offset = getOffset();
 		const float x = position.column + offset.x();
 		const float y = position.row + offset.y();
 
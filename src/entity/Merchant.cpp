@@ -36,7 +36,7 @@ namespace Game3 {
 	}
 
 	bool Merchant::onInteractNextTo(const std::shared_ptr<Player> &player) {
-		auto &window = getRealm()->getGame().canvas.window;
+		auto &window = getRealm()->getGame().canvas->window;
 		auto &tab = *window.merchantTab;
 		player->queueForMove([player, &tab](const auto &) {
 			tab.hide();
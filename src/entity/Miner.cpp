@@ -25,7 +25,7 @@ namespace Game3 {
 		Entity(ID()), Worker(ID(), overworld_realm, house_realm, house_position, keep_) {}
 
 	std::shared_ptr<Miner> Miner::create(Game &game, RealmID overworld_realm, RealmID house_realm, const Position &house_position, const std::shared_ptr<Building> &keep_) {
-		auto out = std::shared_ptr<Miner>(new Miner(overworld_realm, house_realm, house_position, keep_));
+		auto out = makePooled<Miner>([&](void *storage) { return new (storage) Miner(overworld_realm, house_realm, house_position, keep_); });
 		out->init(game);
 		return out;
 	}
@@ -52,7 +52,7 @@ namespace Game3 {
 	}
 
 	bool Miner::onInteractNextTo(const std::shared_ptr<Player> &player) {
-		auto &tab = *getRealm()->getGame().canvas.window.inventoryTab;
+		auto &tab = *getRealm()->getGame().canvas->window.inventoryTab;
 		std::cout << "Miner: money = " << money << ", phase = " << int(phase) << ", stuck = " << stuck << '\n';
 		player->queueForMove([player, &tab](const auto &) {
 			tab.resetExternalInventory();
@@ -113,15 +113,19 @@ namespace Game3 {
 	}
 
 	void Miner::wakeUp() {
+		// This reads the overworld, which might be ticking on another thread.
+		if (Realm::isTickingInParallel())
+			return Realm::deferShared([self = std::dynamic_pointer_cast<Miner>(shared_from_this())] { self->wakeUp(); });
 		phase = 1;
 		auto &game = getRealm()->getGame();
 		auto &overworld = *game.realms.at(overworldRealm);
 		auto &house     = *game.realms.at(houseRealm);
 		// Detect all resources within a given radius of the house
 		std::vector<Index> resource_choices;
-		for (const auto &[index, tile_entity]: overworld.tileEntities)
-			if (dynamic_cast<OreDeposit *>(tile_entity.get()))
-				resource_choices.push_back(index);
+		overworld.iterateTileEntities<OreDeposit>([&](const std::shared_ptr<OreDeposit> &deposit) {
+			resource_choices.push_back(overworld.getIndex(deposit->position));
+			return false;
+		});
 		// If there are no resources, get stuck forever. Seed -1998 has no resources.
 		if (resource_choices.empty()) {
 			phase = -1;
@@ -136,7 +140,7 @@ namespace Game3 {
 	void Miner::goToResource() {
 		auto &realm = *getRealm();
 		auto chosen_position = realm.getPosition(chosenResource);
-		if (auto next = realm.getPathableAdjacent(chosen_position)) {
+		if (auto next = realm.getReachableAdjacent(chosen_position, position)) {
 			if (!pathfind(destination = *next)) {
 				stuck = true;
 				return;
@@ -166,6 +170,9 @@ namespace Game3 {
 	}
 
 	void Miner::sellInventory() {
+		// This changes the keep's money and stockpile, and the keep's realm might be ticking on another thread.
+		if (Realm::isTickingInParallel())
+			return Realm::deferShared([self = std::dynamic_pointer_cast<Miner>(shared_from_this())] { self->sellInventory(); });
 		phase = 7;
 		auto &keep_realm = dynamic_cast<Keep &>(*keep->getInnerRealm());
 		MoneyCount new_money = money;
@@ -92,12 +92,21 @@ namespace Game3 {
 	}
 
 	void Player::teleport(const Position &position, const std::shared_ptr<Realm> &new_realm) {
+		if (Realm::isTickingInParallel())
+			return Realm::deferShared([self = std::dynamic_pointer_cast<Player>(shared_from_this()), position, new_realm] { self->teleport(position, new_realm); });
 		Entity::teleport(position, new_realm);
 		auto &game = new_realm->getGame();
 		game.activeRealm = new_realm;
-		game.canvas.window.activateContext();
-		new_realm->reupload();
-		focus(game.canvas, false);
+		if (!game.isHeadless()) {
+			game.activateContext();
+			new_realm->reupload();
+			focus(*game.canvas, false);
+		}
+	}
+
+	void Player::setSpeed(float new_speed) {
+		speed = new_speed;
+		onSpeedChanged();
 	}
 
 	void Player::addMoney(MoneyCount to_add) {
@@ -117,7 +126,7 @@ namespace Game3 {
 	void Player::showText(const Glib::ustring &text, const Glib::ustring &name) {
 		getRealm()->getGame().setText(text, name, true, true);
 		queueForMove([player = shared_from_this()](const auto &) {
-			player->getRealm()->getGame().canvas.window.textTab->hide();
+			player->getRealm()->getGame().canvas->window.textTab->hide();
 			return true;
 		});
 	}
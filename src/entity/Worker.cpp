@@ -49,6 +49,13 @@ namespace Game3 {
 			throw std::runtime_error("Couldn't find keep for worker");
 	}
 
+	bool Worker::isBusy() const {
+		if (hasPath())
+			return true;
+		// Stuck workers only count down until they retry, and phase -1 means the worker has given up for good.
+		return !stuck && phase != 0 && phase != getRestingPhase() && phase != Phase(-1);
+	}
+
 	bool Worker::stillStuck(float delta) {
 		if (stuck) {
 			if ((stuckTime += delta) < RETRY_TIME)
@@ -70,6 +77,9 @@ namespace Game3 {
 	}
 
 	void Worker::goToStockpile(Phase new_phase) {
+		// This reads the keep's realm, which might be ticking on another thread.
+		if (Realm::isTickingInParallel())
+			return Realm::deferShared([self = std::dynamic_pointer_cast<Worker>(shared_from_this()), new_phase] { self->goToStockpile(new_phase); });
 		keep->teleport(shared_from_this());
 		auto keep_realm = keep->getInnerRealm();
 		auto stockpile = keep_realm->getTileEntity<Chest>();
@@ -107,6 +117,9 @@ namespace Game3 {
 	}
 
 	void Worker::goToBed(Phase new_phase) {
+		// This reads the house's realm, which might be ticking on another thread.
+		if (Realm::isTickingInParallel())
+			return Realm::deferShared([self = std::dynamic_pointer_cast<Worker>(shared_from_this()), new_phase] { self->goToBed(new_phase); });
 		auto house = std::dynamic_pointer_cast<Building>(getRealm()->getGame().realms.at(overworldRealm)->tileEntityAt(housePosition));
 		if (!house)
 			throw std::runtime_error("Worker of type " + type.str() + " couldn't find house at " + std::string(housePosition));
@@ -3,9 +3,31 @@
 #include "game/BiomeMap.h"
 
 namespace Game3 {
+	size_t BiomeMap::getStorageSize() const {
+		if (layout == TileLayout::RowMajor)
+			return static_cast<size_t>(width) * height;
+		return static_cast<size_t>(updiv<Index>(width, TileChunk::SIZE) * updiv<Index>(height, TileChunk::SIZE) * TileChunk::AREA);
+	}
+
+	void BiomeMap::setLayout(TileLayout new_layout) {
+		if (new_layout == layout)
+			return;
+
+		BiomeMap old_map(std::move(*this));
+		layout = new_layout;
+		width  = old_map.width;
+		height = old_map.height;
+		tiles.assign(getStorageSize(), 0);
+
+		for (Index y = 0; y < height; ++y)
+			for (Index x = 0; x < width; ++x)
+				(*this)(x, y) = old_map(x, y);
+	}
+
 	void to_json(nlohmann::json &json, const BiomeMap &tilemap) {
 		json["height"] = tilemap.height;
 		json["width"]  = tilemap.width;
+		json["layout"] = static_cast<int>(tilemap.layout);
 
 		// TODO: fix endianness issues
 		const auto tiles_size = tilemap.tiles.size() * sizeof(tilemap.tiles[0]);
@@ -21,31 +43,19 @@ namespace Game3 {
 	void from_json(const nlohmann::json &json, BiomeMap &tilemap) {
 		tilemap.height = json.at("height");
 		tilemap.width  = json.at("width");
+		// Older saves don't record a layout and are always row-major.
+		tilemap.layout = json.contains("layout")? static_cast<TileLayout>(json.at("layout").get<int>()) : TileLayout::RowMajor;
+		if (tilemap.layout != TileLayout::RowMajor && tilemap.layout != TileLayout::Morton)
+			throw std::runtime_error("Invalid biome map layout");
 
 		// TODO: fix endianness issues
-		tilemap.tiles.clear();
-		const size_t out_size = ZSTD_DStreamOutSize();
-		std::vector<uint8_t> out_buffer(out_size);
-		std::vector<uint8_t> bytes = json.at("tiles");
-
-		auto context = std::unique_ptr<ZSTD_DCtx, size_t(*)(ZSTD_DCtx *)>(ZSTD_createDCtx(), ZSTD_freeDCtx);
-		auto stream = std::unique_ptr<ZSTD_DStream, size_t(*)(ZSTD_DStream *)>(ZSTD_createDStream(), ZSTD_freeDStream);
-
-		ZSTD_inBuffer input {bytes.data(), bytes.size(), 0};
-
-		size_t last_result = 0;
-
-		while (input.pos < input.size) {
-			ZSTD_outBuffer output {&out_buffer[0], out_size, 0};
-			const size_t result = ZSTD_decompressStream(stream.get(), &output, &input);
-			if (ZSTD_isError(result))
-				throw std::runtime_error("Couldn't decompress tiles");
-			last_result = result;
-			const TileID *raw_tiles = reinterpret_cast<const TileID *>(out_buffer.data());
-			tilemap.tiles.insert(tilemap.tiles.end(), raw_tiles, raw_tiles + output.pos / sizeof(TileID));
-		}
-
-		if (last_result != 0)
-			throw std::runtime_error("Reached end of tile input without finishing decompression");
+		tilemap.tiles.assign(tilemap.getStorageSize(), 0);
+		const std::vector<uint8_t> bytes = json.at("tiles");
+		const size_t tiles_size = tilemap.tiles.size() * sizeof(tilemap.tiles[0]);
+		const size_t result = ZSTD_decompress(tilemap.tiles.data(), tiles_size, bytes.data(), bytes.size());
+		if (ZSTD_isError(result))
+			throw std::runtime_error("Couldn't decompress tiles: " + std::string(ZSTD_getErrorName(result)));
+		if (result != tiles_size)
+			throw std::runtime_error("Decompressed biome data is the wrong size");
 	}
 }
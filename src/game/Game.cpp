@@ -1,9 +1,14 @@
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 
 #include <nlohmann/json.hpp>
 
+#include "Texture.h"
+#include "ThreadContext.h"
+#include "Tileset.h"
 #include "entity/Blacksmith.h"
 #include "entity/Chicken.h"
 #include "entity/EntityFactory.h"
@@ -18,6 +23,7 @@
 #include "game/Game.h"
 #include "game/InteractionSet.h"
 #include "game/Inventory.h"
+#include "game/SaveFile.h"
 #include "item/Bomb.h"
 #include "item/CaveEntrance.h"
 #include "item/Furniture.h"
@@ -31,6 +37,7 @@
 #include "item/Tool.h"
 #include "realm/Keep.h"
 #include "realm/RealmFactory.h"
+#include "realm/TileEntitySlots.h"
 #include "recipe/CraftingRecipe.h"
 #include "registry/Registries.h"
 #include "tileentity/Building.h"
@@ -49,8 +56,11 @@
 #include "ui/MainWindow.h"
 #include "ui/tab/TextTab.h"
 #include "util/AStar.h"
+#include "util/ThreadPool.h"
 #include "util/Timer.h"
 #include "util/Util.h"
+#include "worldgen/Overworld.h"
+#include "worldgen/WorldGen.h"
 
 namespace Game3 {
 	void Game::initRegistries() {
@@ -254,6 +264,41 @@ namespace Game3 {
 			interactionSets.emplace(type, standard);
 	}
 
+	void Game::generateWorld(size_t seed, int width, int height, const WorldGenParams &params) {
+		initEntities();
+		auto tileset = registry<TilesetRegistry>().at("base:tileset/monomap"_id);
+		auto tileset_texture = tileset->getTexture(*this);
+		auto tilemap = std::make_shared<Tilemap>(width, height, 16, *tileset_texture->width, *tileset_texture->height, tileset);
+		tilemap->init(*this);
+		auto biomemap = std::make_shared<BiomeMap>(width, height);
+		auto realm = Realm::create(*this, 1, "base:realm/overworld"_id, tilemap, biomemap, seed);
+		realm->outdoors = true;
+		WorldGen::generateOverworld(realm, seed, params);
+		realms.emplace(realm->id, realm);
+		activeRealm = realm;
+		player = Entity::create<Player>();
+		player->position = {realm->randomLand / width, realm->randomLand % width};
+		realm->add(player);
+		player->init(*this);
+	}
+
+	void Game::initAfterLoad() {
+		initEntities();
+		for (auto &[id, realm]: realms)
+			realm->remakePathMap();
+		for (const auto &entity: activeRealm->entities)
+			if (entity->isPlayer()) {
+				if (!(player = std::dynamic_pointer_cast<Player>(entity)))
+					throw std::runtime_error("Couldn't cast entity with isPlayer() == true to Player");
+				break;
+			}
+		if (!player)
+			throw std::runtime_error("Player not found in active realm");
+		for (const auto &[id, realm]: realms)
+			for (const auto &entity: realm->entities)
+				entity->initAfterLoad(*this);
+	}
+
 	void Game::add(std::shared_ptr<Item> item) {
 		registry<ItemRegistry>().add(item->identifier, item);
 		for (const auto &attribute: item->attributes)
@@ -406,6 +451,65 @@ namespace Game3 {
 				}
 				return {false, "Unknown item: " + item_name};
 			}
+
+			if (first == "tickrate") {
+				if (words.size() != 2)
+					return {false, "Usage: tickrate <ticks per second>"};
+				double rate = 0.;
+				try {
+					rate = std::stod(words.at(1).raw());
+				} catch (const std::exception &) {
+					return {false, "Invalid tick rate."};
+				}
+				if (!(0. < rate))
+					return {false, "Invalid tick rate."};
+				tickRate = rate;
+				return {true, "Tick rate set to " + std::to_string(rate) + " per second."};
+			}
+
+			if (first == "parallelrealms") {
+				if (words.size() != 2 || (words.at(1) != "on" && words.at(1) != "off"))
+					return {false, "Usage: parallelrealms on|off"};
+				parallelRealms = words.at(1) == "on";
+				return {true, parallelRealms? "Parallel realm ticking enabled." : "Parallel realm ticking disabled."};
+			}
+
+			if (first == "parallel") {
+				if (words.size() != 2 || (words.at(1) != "on" && words.at(1) != "off"))
+					return {false, "Usage: parallel on|off"};
+				const bool enable = words.at(1) == "on";
+				for (auto &[id, realm]: realms)
+					realm->parallelTick = enable;
+				return {true, enable? "Parallel ticking enabled." : "Parallel ticking disabled."};
+			}
+
+			if (first == "save") {
+				if (words.size() < 2 || 3 < words.size())
+					return {false, "Usage: save <path> [best|fast|uncompressed]"};
+				int compression_level = Tilemap::DEFAULT_COMPRESSION_LEVEL;
+				if (words.size() == 3) {
+					if (words.at(2) == "fast")
+						compression_level = Tilemap::FAST_COMPRESSION_LEVEL;
+					else if (words.at(2) == "uncompressed")
+						compression_level = Tilemap::UNCOMPRESSED;
+					else if (words.at(2) != "best")
+						return {false, "Usage: save <path> [best|fast|uncompressed]"};
+				}
+				nlohmann::json json;
+				toJSON(json, compression_level);
+				writeSave(words.at(1).raw(), std::move(json));
+				return {true, "Saved to " + words.at(1) + "."};
+			}
+
+			if (first == "cells") {
+				if (words.size() != 2 || (words.at(1) != "on" && words.at(1) != "off"))
+					return {false, "Usage: cells on|off"};
+				if (!activeRealm)
+					return {false, "No active realm."};
+				const bool enable = words.at(1) == "on";
+				activeRealm->setCellsEnabled(enable);
+				return {true, enable? "Cell records enabled for the current realm." : "Cell records disabled for the current realm."};
+			}
 		} catch (const std::exception &err) {
 			return {false, err.what()};
 		}
@@ -417,10 +521,95 @@ namespace Game3 {
 		auto now = getTime();
 		auto difference = now - lastTime;
 		lastTime = now;
-		delta = std::chrono::duration_cast<std::chrono::nanoseconds>(difference).count() / 1'000'000'000.;
-		for (auto &[id, realm]: realms)
-			realm->tick(delta);
+		tickAccumulator += std::chrono::duration_cast<std::chrono::nanoseconds>(difference).count() / 1'000'000'000.;
+
+		const double step = 1. / tickRate;
+		for (size_t ticks = 0; step <= tickAccumulator; ++ticks) {
+			if (maxTicksPerFrame <= ticks) {
+				tickAccumulator = std::fmod(tickAccumulator, step);
+				break;
+			}
+			tickAccumulator -= step;
+			runTick(step);
+		}
+	}
+
+	size_t Game::simulate(double seconds) {
+		const double step = 1. / tickRate;
+		// The epsilon keeps a whole number of ticks' worth of seconds from rounding down to one tick fewer.
+		const size_t ticks = static_cast<size_t>(seconds * tickRate + 1e-6);
+		for (size_t i = 0; i < ticks; ++i)
+			runTick(step);
+		return ticks;
+	}
+
+	void Game::runTick(float delta_) {
+		delta = delta_;
+		totalSeconds += delta_;
+		tickRealms(delta_);
 		player->ticked = false;
+
+		// Every realm has ticked, so tile entities removed during this tick can be released once no other thread is
+		// still looking them up. Idle realms are included so that their removals don't wait for their next tick.
+		TileEntitySlots::advanceGlobalEpoch();
+		for (auto &[id, realm]: realms)
+			realm->reclaimTileEntities();
+	}
+
+	void Game::tickRealms(float delta_) {
+		if (!parallelRealms || realms.size() < 2) {
+			for (auto &[id, realm]: realms)
+				realm->update(delta_);
+			return;
+		}
+
+		std::vector<RealmPtr> concurrent;
+		concurrent.reserve(realms.size());
+		for (const auto &[id, realm]: realms)
+			concurrent.push_back(realm);
+		std::sort(concurrent.begin(), concurrent.end(), [](const RealmPtr &left, const RealmPtr &right) {
+			return left->id < right->id;
+		});
+
+		// The active realm ticks the player, which talks to the UI, and realms that tick in regions use the pool
+		// themselves, so those are ticked on this thread first. Ticking one can move the player into another realm.
+		auto must_tick_here = [this](const RealmPtr &realm) {
+			return realm == activeRealm || realm->parallelTick;
+		};
+		for (;;) {
+			auto iter = std::find_if(concurrent.begin(), concurrent.end(), must_tick_here);
+			if (iter == concurrent.end())
+				break;
+			auto realm = std::move(*iter);
+			concurrent.erase(iter);
+			realm->update(delta_);
+		}
+
+		// The buffers are normally emptied at the end of the previous tick, but not if it threw.
+		for (auto &commands: realmCommands)
+			commands.clear();
+		realmCommands.resize(concurrent.size());
+
+		getTickPool().run(concurrent.size(), [&](size_t index) {
+			threadContext.commandBuffer = &realmCommands[index];
+			threadContext.exclusiveRealm = concurrent[index].get();
+			try {
+				concurrent[index]->update(delta_);
+			} catch (...) {
+				threadContext.commandBuffer = nullptr;
+				threadContext.exclusiveRealm = nullptr;
+				throw;
+			}
+			threadContext.commandBuffer = nullptr;
+			threadContext.exclusiveRealm = nullptr;
+		});
+
+		// Applied in realm ID order so that the result doesn't depend on how the threads were scheduled.
+		for (auto &commands: realmCommands) {
+			for (auto &command: commands)
+				command();
+			commands.clear();
+		}
 	}
 
 	RealmID Game::newRealmID() const {
@@ -432,8 +621,8 @@ namespace Game3 {
 	}
 
 	void Game::setText(const Glib::ustring &text, const Glib::ustring &name, bool focus, bool ephemeral) {
-		if (canvas.window.textTab) {
-			auto &tab = *canvas.window.textTab;
+		if (canvas && canvas->window.textTab) {
+			auto &tab = *canvas->window.textTab;
 			tab.text = text;
 			tab.name = name;
 			tab.ephemeral = ephemeral;
@@ -444,8 +633,8 @@ namespace Game3 {
 	}
 
 	const Glib::ustring & Game::getText() const {
-		if (canvas.window.textTab)
-			return canvas.window.textTab->text;
+		if (canvas && canvas->window.textTab)
+			return canvas->window.textTab->text;
 		throw std::runtime_error("Can't get text: TextTab is null");
 	}
 
@@ -454,8 +643,8 @@ namespace Game3 {
 			return;
 
 		auto &realm = *activeRealm;
-		const auto width  = canvas.width();
-		const auto height = canvas.height();
+		const auto width  = canvas->width();
+		const auto height = canvas->height();
 
 		// Lovingly chosen by trial and error.
 		if (0 < realm.ghostCount && width - 40.f <= pos_x && pos_x < width - 16.f && height - 40.f <= pos_y && pos_y < height - 16.f) {
@@ -476,17 +665,17 @@ namespace Game3 {
 	Position Game::translateCanvasCoordinates(double x, double y) const {
 		const auto &realm   = *activeRealm;
 		const auto &tilemap = realm.tilemap1;
-		const auto scale    = canvas.scale;
-		x -= canvas.width() / 2.f - (tilemap->width * tilemap->tileSize / 4.f) * scale + canvas.center.x() * canvas.magic * scale;
+		const auto scale    = canvas->scale;
+		x -= canvas->width() / 2.f - (tilemap->width * tilemap->tileSize / 4.f) * scale + canvas->center.x() * canvas->magic * scale;
 		x /= tilemap->tileSize * scale / 2.f;
-		y -= canvas.height() / 2.f - (tilemap->height * tilemap->tileSize / 4.f) * scale + canvas.center.y() * canvas.magic * scale;
+		y -= canvas->height() / 2.f - (tilemap->height * tilemap->tileSize / 4.f) * scale + canvas->center.y() * canvas->magic * scale;
 		y /= tilemap->tileSize * scale / 2.f;
 		return {static_cast<Index>(x), static_cast<Index>(y)};
 	}
 
 	Gdk::Rectangle Game::getVisibleRealmBounds() const {
 		const auto [left,     top] = translateCanvasCoordinates(0., 0.);
-		const auto [right, bottom] = translateCanvasCoordinates(canvas.width(), canvas.height());
+		const auto [right, bottom] = translateCanvasCoordinates(canvas->width(), canvas->height());
 		return {
 			static_cast<int>(left),
 			static_cast<int>(top),
@@ -495,12 +684,8 @@ namespace Game3 {
 		};
 	}
 
-	double Game::getTotalSeconds() const {
-		return std::chrono::duration_cast<std::chrono::nanoseconds>(getTime() - startTime).count() / 1e9;
-	}
-
 	double Game::getHour() const {
-		const auto base = getTotalSeconds() / 10. + hourOffset;
+		const auto base = getTotalSeconds() / SECONDS_PER_HOUR + hourOffset;
 		return static_cast<long>(base) % 24 + fractional(base);
 	}
 
@@ -513,39 +698,72 @@ namespace Game3 {
 	}
 
 	void Game::activateContext() {
-		canvas.window.activateContext();
+		if (canvas)
+			canvas->window.activateContext();
 	}
 
 	MainWindow & Game::getWindow() {
-		return canvas.window;
+		if (!canvas)
+			throw std::runtime_error("Headless games have no window");
+		return canvas->window;
+	}
+
+	ThreadPool & Game::getTickPool() {
+		if (!tickPool)
+			tickPool = std::make_shared<ThreadPool>();
+		return *tickPool;
 	}
 
 	GamePtr Game::create(Canvas &canvas) {
-		auto out = GamePtr(new Game(canvas));
+		auto out = GamePtr(new Game(&canvas));
 		out->initialSetup();
 		return out;
 	}
 
-	GamePtr Game::fromJSON(const nlohmann::json &json, Canvas &canvas) {
+	GamePtr Game::fromJSON(const nlohmann::json &json, Canvas &canvas, std::shared_ptr<MappedFile> mapped_save) {
 		auto out = create(canvas);
+		out->absorbJSON(json, std::move(mapped_save));
+		return out;
+	}
+
+	GamePtr Game::createHeadless() {
+		Texture::headless = true;
+		auto out = GamePtr(new Game(nullptr));
 		out->initialSetup();
-		for (const auto &[string, realm_json]: json.at("realms").get<std::unordered_map<std::string, nlohmann::json>>())
-			out->realms.emplace(parseUlong(string), Realm::fromJSON(*out, realm_json));
-		out->activeRealm = out->realms.at(json.at("activeRealmID"));
-		out->hourOffset = json.contains("hourOffset")? json.at("hourOffset").get<float>() : 0.f;
-		out->debugMode = json.contains("debugMode")? json.at("debugMode").get<bool>() : false;
-		out->cavesGenerated = json.contains("cavesGenerated")? json.at("cavesGenerated").get<decltype(Game::cavesGenerated)>() : 0;
 		return out;
 	}
 
-	void to_json(nlohmann::json &json, const Game &game) {
-		json["activeRealmID"] = game.activeRealm->id;
-		json["debugMode"] = game.debugMode;
+	GamePtr Game::fromJSONHeadless(const nlohmann::json &json, std::shared_ptr<MappedFile> mapped_save) {
+		auto out = createHeadless();
+		out->absorbJSON(json, std::move(mapped_save));
+		return out;
+	}
+
+	void Game::absorbJSON(const nlohmann::json &json, std::shared_ptr<MappedFile> mapped_save) {
+		mappedSave = std::move(mapped_save);
+		for (const auto &[string, realm_json]: json.at("realms").get<std::unordered_map<std::string, nlohmann::json>>())
+			realms.emplace(parseUlong(string), Realm::fromJSON(*this, realm_json));
+		activeRealm = realms.at(json.at("activeRealmID"));
+		hourOffset = json.contains("hourOffset")? json.at("hourOffset").get<float>() : 0.f;
+		debugMode = json.contains("debugMode")? json.at("debugMode").get<bool>() : false;
+		cavesGenerated = json.contains("cavesGenerated")? json.at("cavesGenerated").get<decltype(Game::cavesGenerated)>() : 0;
+		// Chunks that use regions of the mapping in place hold their own references to it, so it's unmapped as soon as
+		// the last of them has copied its tiles out.
+		mappedSave.reset();
+	}
+
+	void Game::toJSON(nlohmann::json &json, int compression_level) const {
+		json["activeRealmID"] = activeRealm->id;
+		json["debugMode"] = debugMode;
 		json["realms"] = std::unordered_map<std::string, nlohmann::json>();
-		for (const auto &[id, realm]: game.realms)
-			json["realms"][std::to_string(id)] = nlohmann::json(*realm);
-		json["hourOffset"] = game.getHour();
-		if (0 < game.cavesGenerated)
-			json["cavesGenerated"] = game.cavesGenerated;
+		for (const auto &[id, realm]: realms)
+			realm->toJSON(json["realms"][std::to_string(id)], compression_level);
+		json["hourOffset"] = getHour();
+		if (0 < cavesGenerated)
+			json["cavesGenerated"] = cavesGenerated;
+	}
+
+	void to_json(nlohmann::json &json, const Game &game) {
+		game.toJSON(json);
 	}
 }
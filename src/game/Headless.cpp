@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "game/Game.h"
+#include "game/Headless.h"
+#include "game/SaveFile.h"
+#include "util/FS.h"
+#include "worldgen/WorldGen.h"
+
+namespace Game3 {
+	constexpr static size_t HEADLESS_SEED = 1621;
+	constexpr static int HEADLESS_WIDTH  = 256;
+	constexpr static int HEADLESS_HEIGHT = 256;
+
+	static GamePtr loadHeadless(const std::filesystem::path &path) {
+		GamePtr game;
+		if (isSaveContainer(path)) {
+			auto mapping = std::make_shared<MappedFile>(path);
+			game = Game::fromJSONHeadless(readSave(*mapping), mapping);
+		} else {
+			const std::string data = readFile(path);
+			if (!data.empty() && data.front() == '{')
+				game = Game::fromJSONHeadless(nlohmann::json::parse(data));
+			else
+				game = Game::fromJSONHeadless(nlohmann::json::from_cbor(data));
+		}
+		game->initAfterLoad();
+		return game;
+	}
+
+	int runHeadless(int argc, char **argv) {
+		if (argc < 4 || 5 < argc) {
+			std::cerr << "Usage: " << argv[0] << " --headless <hours> <output path> [input path]\n";
+			return 1;
+		}
+
+		double hours = 0.;
+		try {
+			hours = std::stod(argv[2]);
+		} catch (const std::exception &) {}
+		if (!(0. < hours)) {
+			std::cerr << "Invalid hour count: " << argv[2] << '\n';
+			return 1;
+		}
+
+		const std::filesystem::path output_path = argv[3];
+
+		try {
+			GamePtr game;
+			if (argc == 5) {
+				game = loadHeadless(argv[4]);
+			} else {
+				game = Game::createHeadless();
+				game->generateWorld(HEADLESS_SEED, HEADLESS_WIDTH, HEADLESS_HEIGHT, WorldGenParams());
+			}
+			game->initInteractionSets();
+
+			size_t total_ticks = 0;
+			const auto start = std::chrono::steady_clock::now();
+			for (double hour = 0.; hour < hours; ++hour) {
+				const auto hour_start = std::chrono::steady_clock::now();
+				const size_t ticks = game->simulate(std::min(1., hours - hour) * Game::SECONDS_PER_HOUR);
+				const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - hour_start).count();
+				total_ticks += ticks;
+				std::cerr << "Hour " << hour + 1 << ": " << ticks << " ticks in " << elapsed << "s (" << ticks / elapsed << " ticks/s)\n";
+			}
+			const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::cerr << "Simulated " << hours << " hours (" << total_ticks << " ticks) in " << elapsed << "s: " << total_ticks / elapsed
+			          << " ticks/s, " << hours * Game::SECONDS_PER_HOUR / elapsed << "x real time\n";
+
+			// Headless runs are mostly benchmarks and are saved every time, so the save shouldn't dominate the run.
+			nlohmann::json json;
+			game->toJSON(json, Tilemap::FAST_COMPRESSION_LEVEL);
+			writeSave(output_path, std::move(json));
+		} catch (const std::exception &err) {
+			std::cerr << "Headless run failed: " << err.what() << '\n';
+			return 1;
+		}
+
+		return 0;
+	}
+}
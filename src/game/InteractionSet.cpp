@@ -42,8 +42,6 @@ namespace Game3 {
 				if (tile2 == "base:tile/ash"_id) {
 					realm.setLayer2(position, "base:tile/empty"_id);
 					player.give({game, "base:item/ash"_id, 1});
-					realm.getGame().activateContext();
-					realm.reupload();
 					return true;
 				}
 			}
@@ -89,8 +87,6 @@ namespace Game3 {
 					if (auto cast = std::dynamic_pointer_cast<Plantable>(item); cast && cast->tilename == tile2) {
 						player.give({game, item});
 						realm.setLayer2(position, tileset.getEmptyID());
-						game.activateContext();
-						realm.renderer2.reupload();
 						return true;
 					}
 				}
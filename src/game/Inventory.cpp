@@ -364,10 +364,13 @@ namespace Game3 {
 
 	void Inventory::notifyOwner() {
 		if (auto locked_owner = owner.lock()) {
-			if (auto player = std::dynamic_pointer_cast<Player>(locked_owner))
-				player->getRealm()->getGame().signal_player_inventory_update().emit(player);
-			else
-				locked_owner->getRealm()->getGame().signal_other_inventory_update().emit(locked_owner);
+			// The signals update the UI, so they're held back until the end of a parallel tick.
+			Realm::deferShared([locked_owner] {
+				if (auto player = std::dynamic_pointer_cast<Player>(locked_owner))
+					player->getRealm()->getGame().signal_player_inventory_update().emit(player);
+				else
+					locked_owner->getRealm()->getGame().signal_other_inventory_update().emit(locked_owner);
+			});
 		}
 	}
 
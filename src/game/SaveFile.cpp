@@ -0,0 +1,104 @@
+#include <cstring>
+#include <fstream>
+#include <functional>
+
+#include "game/SaveFile.h"
+#include "util/Endian.h"
+#include "util/FS.h"
+
+namespace Game3 {
+	namespace {
+		constexpr char SAVE_MAGIC[8] {'G', 'a', 'm', 'e', '3', 'S', 'a', 'v'};
+		constexpr size_t SAVE_HEADER_SIZE = sizeof(SAVE_MAGIC) + sizeof(uint64_t);
+
+		inline size_t align(size_t offset) {
+			return (offset + 7) & ~size_t(7);
+		}
+	}
+
+	void writeSave(const std::filesystem::path &path, nlohmann::json document) {
+		std::vector<nlohmann::json::binary_t> blobs;
+		size_t blobs_size = 0;
+
+		std::function<void(nlohmann::json &)> hoist = [&](nlohmann::json &node) {
+			if (node.is_binary()) {
+				const size_t size = node.get_binary().size();
+				blobs.push_back(std::move(node.get_binary()));
+				node = {{"blobOffset", blobs_size}, {"blobSize", size}};
+				blobs_size = align(blobs_size + size);
+			} else if (node.is_structured()) {
+				for (auto &child: node)
+					hoist(child);
+			}
+		};
+
+		hoist(document);
+
+		const auto cbor = nlohmann::json::to_cbor(document);
+
+		std::filesystem::path temporary_path = path;
+		temporary_path += ".tmp";
+
+		std::ofstream stream(temporary_path, std::ios::binary);
+		if (!stream.is_open())
+			throw std::runtime_error("Couldn't open file for writing");
+
+		char header[SAVE_HEADER_SIZE];
+		std::memcpy(header, SAVE_MAGIC, sizeof(SAVE_MAGIC));
+		writeLittle<uint64_t>(header + sizeof(SAVE_MAGIC), cbor.size());
+		stream.write(header, sizeof(header));
+		stream.write(reinterpret_cast<const char *>(cbor.data()), cbor.size());
+
+		static constexpr char padding[8] {};
+		size_t position = SAVE_HEADER_SIZE + cbor.size();
+		stream.write(padding, align(position) - position);
+
+		for (const auto &blob: blobs) {
+			stream.write(reinterpret_cast<const char *>(blob.data()), blob.size());
+			stream.write(padding, align(blob.size()) - blob.size());
+		}
+
+		stream.close();
+		if (!stream)
+			throw std::runtime_error("Couldn't write save file");
+
+		std::filesystem::rename(temporary_path, path);
+	}
+
+	bool isSaveContainer(const MappedFile &file) {
+		return SAVE_HEADER_SIZE <= file.size() && std::memcmp(file.data(), SAVE_MAGIC, sizeof(SAVE_MAGIC)) == 0;
+	}
+
+	bool isSaveContainer(const std::filesystem::path &path) {
+		std::ifstream stream(path, std::ios::binary);
+		char header[SAVE_HEADER_SIZE];
+		if (!stream.read(header, sizeof(header)))
+			return false;
+		return std::memcmp(header, SAVE_MAGIC, sizeof(SAVE_MAGIC)) == 0;
+	}
+
+	nlohmann::json readSave(const MappedFile &file) {
+		if (!isSaveContainer(file))
+			throw std::runtime_error("Not a save container");
+
+		const size_t document_size = readLittle<uint64_t>(file.data() + sizeof(SAVE_MAGIC));
+		if (file.size() - SAVE_HEADER_SIZE < document_size)
+			throw std::runtime_error("Save file is truncated");
+
+		const uint8_t *document_start = file.data() + SAVE_HEADER_SIZE;
+		auto document = nlohmann::json::from_cbor(document_start, document_start + document_size);
+		const size_t blobs_start = align(SAVE_HEADER_SIZE + document_size);
+
+		std::function<void(nlohmann::json &)> rebase = [&](nlohmann::json &node) {
+			if (node.is_object() && node.contains("blobOffset") && node.contains("blobSize")) {
+				node["blobOffset"] = blobs_start + node.at("blobOffset").get<size_t>();
+			} else if (node.is_structured()) {
+				for (auto &child: node)
+					rebase(child);
+			}
+		};
+
+		rebase(document);
+		return document;
+	}
+}
@@ -15,6 +15,7 @@ namespace Game3 {
 
 		auto &realm  = *place.realm;
 		const auto [prow, pcol] = place.position;
+		Realm::NeighborBatch batch(realm);
 
 		for (Index row = prow - RADIUS * 2; row <= prow + RADIUS * 2; ++row) {
 			for (Index column = pcol - RADIUS * 2; column <= pcol + RADIUS * 2; ++column) {
@@ -27,9 +28,6 @@ namespace Game3 {
 			}
 		}
 
-		realm.getGame().activateContext();
-		realm.reupload();
-
 		return true;
 	}
 }
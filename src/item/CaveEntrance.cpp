@@ -34,17 +34,17 @@ namespace Game3 {
 		// Resetting the sprite renderer exactly one time fixes things. I'm not sure what the earliest possible time to reset it is.
 		// However, doing it here seems to work.
 		static bool hacked = false;
-		if (!hacked) {
+		if (!hacked && !game.isHeadless()) {
 			game.activateContext();
-			game.canvas.spriteRenderer = SpriteRenderer(game.canvas);
+			game.canvas->spriteRenderer = SpriteRenderer(*game.canvas);
 			hacked = true;
 		}
 
 		std::optional<RealmID> realm_id;
 		Index entrance = -1;
 
-		for (const auto &[index, tile_entity]: realm.tileEntities)
-			if (tile_entity->tileID == "base:tile/cave"_id && tile_entity->is("base:te/building"_id))
+		for (const auto &[index, tile_entity]: realm.getTileEntitiesByTileID("base:tile/cave"_id))
+			if (tile_entity->is("base:te/building"_id))
 				if (auto building = std::dynamic_pointer_cast<Building>(tile_entity)) {
 					realm_id = building->innerRealmID;
 					if (auto cave_realm = std::dynamic_pointer_cast<Cave>(game.realms.at(*realm_id)))
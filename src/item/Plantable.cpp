@@ -22,8 +22,6 @@ namespace Game3 {
 		if (realm.pathMap[realm.getIndex(position)] && tileset.getEmptyID() == realm.getLayer2(position)) {
 			if (!validGround || tileset.isInCategory(tileset[realm.getLayer1(position)], validGround)) {
 				realm.setLayer2(position, tilename);
-				realm.getGame().activateContext();
-				realm.renderer2.reupload();
 				if (--stack.count == 0)
 					place.player->inventory->erase(slot);
 				place.player->inventory->notifyOwner();
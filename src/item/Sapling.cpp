@@ -28,7 +28,7 @@ namespace Game3 {
 			if (--stack.count == 0)
 				player.inventory->erase(slot);
 			player.inventory->notifyOwner();
-			realm.pathMap[index] = 0;
+			realm.setPathable(index, false);
 			return true;
 		}
 
@@ -4,6 +4,7 @@
 #include <random>
 
 #include "App.h"
+#include "game/Headless.h"
 
 namespace Game3 {
 	void test();
@@ -17,6 +18,9 @@ int main(int argc, char **argv) {
 		return 0;
 	}
 
+	if (2 <= argc && strcmp(argv[1], "--headless") == 0)
+		return Game3::runHeadless(argc, argv);
+
 	auto app = Game3::App::create();
 	const int out = app->run(argc, argv);
 	return out;
@@ -20,9 +20,7 @@ namespace Game3 {
 		// - All cave entrances in a given realm lead to the same cave.
 		//    -> If we find one cave entrance in a realm, we can stop after destroying its linked cave and we don't have to look for more entrances.
 		auto &game = getGame();
-		for (const auto &[index, tile_entity]: tileEntities) {
-			if (tile_entity->tileID != "base:tile/cave"_id)
-				continue;
+		for (const auto &[index, tile_entity]: getTileEntitiesByTileID("base:tile/cave"_id)) {
 			if (auto building = std::dynamic_pointer_cast<Building>(tile_entity)) {
 				if (auto cave_realm = std::dynamic_pointer_cast<Cave>(game.realms.at(building->innerRealmID)))
 					game.realms.erase(building->innerRealmID);
@@ -64,8 +62,6 @@ namespace Game3 {
 			if (auto *stack = inventory.getActive()) {
 				if (stack->hasAttribute("base:attribute/pickaxe"_id) && !inventory.add(*ore_stack)) {
 					setLayer2(index, tilemap2->tileset->getEmpty());
-					getGame().activateContext();
-					renderer2.reupload();
 					reveal(position);
 					if (stack->reduceDurability())
 						inventory.erase(inventory.activeSlot);
@@ -82,7 +78,6 @@ namespace Game3 {
 			return;
 
 		if ((*tilemap2)[getIndex(position)] == tilemap2->tileset->getEmptyID()) {
-			bool changed = false;
 			const TileID void3 = (*tilemap3->tileset)["base:tile/void"];
 			const TileID empty3 = tilemap3->tileset->getEmptyID();
 			for (Index row_offset = -1; row_offset <= 1; ++row_offset) {
@@ -95,15 +90,12 @@ namespace Game3 {
 						const auto tile3 = (*tilemap3)[index];
 						if (tile3 == void3) {
 							tilemap3->set(index, empty3);
-							changed = true;
+							journal.recordTile(3, offset_position);
+							updateCell(index);
 						}
 					}
 				}
 			}
-			if (changed) {
-				getGame().activateContext();
-				renderer3.reupload();
-			}
 		}
 	}
 
@@ -113,8 +105,8 @@ namespace Game3 {
 		entranceCount = json.contains("entranceCount")? json.at("entranceCount").get<decltype(entranceCount)>() : 1;
 	}
 
-	void Cave::toJSON(nlohmann::json &json) const {
-		Realm::toJSON(json);
+	void Cave::toJSON(nlohmann::json &json, int compression_level) const {
+		Realm::toJSON(json, compression_level);
 		json["parentRealm"] = parentRealm;
 		if (entranceCount != 1)
 			json["entranceCount"] = entranceCount;
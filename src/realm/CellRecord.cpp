@@ -0,0 +1,19 @@
+#include "Tileset.h"
+#include "realm/CellRecord.h"
+
+namespace Game3 {
+	void CellRecord::update(TileID layer1, TileID layer2, TileID layer3, const Tileset &tileset) {
+		layers = {layer1, layer2, layer3};
+		uint16_t new_flags = flags & SOLID_TILE_ENTITY;
+		const bool ground_walkable = tileset.isWalkable(layer1);
+		if (ground_walkable)
+			new_flags |= GROUND_WALKABLE;
+		if (ground_walkable && tileset.isWalkable(layer2) && tileset.isWalkable(layer3))
+			new_flags |= WALKABLE;
+		if (tileset.isSolid(layer2) || tileset.isSolid(layer3))
+			new_flags |= SOLID;
+		if (tileset.isLand(layer1))
+			new_flags |= LAND;
+		flags = new_flags;
+	}
+}
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cmath>
+
+#include "entity/Entity.h"
+#include "realm/EntityGrid.h"
+
+namespace Game3 {
+	void EntityGrid::reset(Index width, Index height) {
+		bucketRows    = std::max<Index>(1, (height + BUCKET_SIZE - 1) >> BUCKET_SHIFT);
+		bucketColumns = std::max<Index>(1, (width  + BUCKET_SIZE - 1) >> BUCKET_SHIFT);
+		buckets.assign(bucketRows * bucketColumns, {});
+		bucketIndices.clear();
+	}
+
+	void EntityGrid::clear() {
+		for (auto &bucket: buckets)
+			bucket.clear();
+		bucketIndices.clear();
+	}
+
+	void EntityGrid::insert(const std::shared_ptr<Entity> &entity) {
+		if (buckets.empty())
+			reset(0, 0);
+		const size_t bucket_index = getBucketIndex(entity->position);
+		if (!bucketIndices.emplace(entity.get(), bucket_index).second)
+			return;
+		buckets[bucket_index].push_back(entity);
+	}
+
+	void EntityGrid::remove(const std::shared_ptr<Entity> &entity) {
+		auto iter = bucketIndices.find(entity.get());
+		if (iter == bucketIndices.end())
+			return;
+		eraseFromBucket(entity.get(), iter->second);
+		bucketIndices.erase(iter);
+	}
+
+	void EntityGrid::update(const std::shared_ptr<Entity> &entity) {
+		auto iter = bucketIndices.find(entity.get());
+		if (iter == bucketIndices.end())
+			return;
+		const size_t new_index = getBucketIndex(entity->position);
+		if (new_index == iter->second)
+			return;
+		eraseFromBucket(entity.get(), iter->second);
+		buckets[new_index].push_back(entity);
+		iter->second = new_index;
+	}
+
+	std::vector<std::shared_ptr<Entity>> EntityGrid::find(const Position &position) const {
+		std::vector<std::shared_ptr<Entity>> out;
+		visit(TileRect{position.row, position.column, 1, 1}, [&](const std::shared_ptr<Entity> &entity) {
+			out.push_back(entity);
+			return false;
+		});
+		return out;
+	}
+
+	std::vector<std::shared_ptr<Entity>> EntityGrid::find(const TileRect &rect) const {
+		std::vector<std::shared_ptr<Entity>> out;
+		visit(rect, [&](const std::shared_ptr<Entity> &entity) {
+			out.push_back(entity);
+			return false;
+		});
+		return out;
+	}
+
+	std::vector<std::shared_ptr<Entity>> EntityGrid::find(const Position &center, double radius) const {
+		std::vector<std::shared_ptr<Entity>> out;
+		if (radius < 0)
+			return out;
+		const Index reach = static_cast<Index>(std::floor(radius));
+		visit(TileRect{center.row - reach, center.column - reach, 2 * reach + 1, 2 * reach + 1}, [&](const std::shared_ptr<Entity> &entity) {
+			if (entity->position.distance(center) <= radius)
+				out.push_back(entity);
+			return false;
+		});
+		return out;
+	}
+
+	Index EntityGrid::clampRow(Index row) const {
+		return std::clamp<Index>(row >> BUCKET_SHIFT, 0, bucketRows - 1);
+	}
+
+	Index EntityGrid::clampColumn(Index column) const {
+		return std::clamp<Index>(column >> BUCKET_SHIFT, 0, bucketColumns - 1);
+	}
+
+	size_t EntityGrid::getBucketIndex(const Position &position) const {
+		return clampRow(position.row) * bucketColumns + clampColumn(position.column);
+	}
+
+	void EntityGrid::eraseFromBucket(const Entity *entity, size_t bucket_index) {
+		auto &bucket = buckets[bucket_index];
+		for (auto iter = bucket.begin(); iter != bucket.end(); ++iter)
+			if (iter->get() == entity) {
+				*iter = std::move(bucket.back());
+				bucket.pop_back();
+				return;
+			}
+	}
+
+	const Position & EntityGrid::entityPosition(const Entity &entity) {
+		return entity.position;
+	}
+}
@@ -27,8 +27,8 @@ namespace Game3 {
 		stockpileInventory = getTileEntity<Chest>([](const auto &chest) { return chest->name == "Stockpile"; })->inventory;
 	}
 
-	void Keep::toJSON(nlohmann::json &json) const {
-		Realm::toJSON(json);
+	void Keep::toJSON(nlohmann::json &json, int compression_level) const {
+		Realm::toJSON(json, compression_level);
 		json["town"]["origin"] = parentOrigin;
 		json["town"]["width"]  = parentWidth;
 		json["town"]["height"] = parentHeight;
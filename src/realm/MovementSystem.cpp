@@ -0,0 +1,107 @@
+#include "entity/Entity.h"
+#include "realm/MovementSystem.h"
+
+namespace Game3 {
+	MovementSystem::~MovementSystem() {
+		clear();
+	}
+
+	void MovementSystem::add(Entity &entity) {
+		if (entity.movementSystem == this)
+			return;
+		if (entity.movementSystem != nullptr)
+			entity.movementSystem->remove(entity);
+		entity.movementSystem = this;
+		entity.movementSlot = owners.size();
+		offsetX.push_back(0.f);
+		offsetY.push_back(0.f);
+		speeds.push_back(entity.getSpeed());
+		nextAxes.push_back(getNextAxis(entity));
+		owners.push_back(&entity);
+	}
+
+	void MovementSystem::remove(Entity &entity) {
+		if (entity.movementSystem != this)
+			return;
+
+		// Fill the hole with the last slot so the arrays stay contiguous.
+		const size_t slot = entity.movementSlot;
+		const size_t last = owners.size() - 1;
+		if (slot != last) {
+			offsetX[slot] = offsetX[last];
+			offsetY[slot] = offsetY[last];
+			speeds[slot]  = speeds[last];
+			nextAxes[slot] = nextAxes[last];
+			owners[slot]  = owners[last];
+			owners[slot]->movementSlot = slot;
+		}
+
+		offsetX.pop_back();
+		offsetY.pop_back();
+		speeds.pop_back();
+		nextAxes.pop_back();
+		owners.pop_back();
+		entity.movementSystem = nullptr;
+	}
+
+	void MovementSystem::clear() {
+		for (Entity *owner: owners)
+			owner->movementSystem = nullptr;
+		offsetX.clear();
+		offsetY.clear();
+		speeds.clear();
+		nextAxes.clear();
+		owners.clear();
+	}
+
+	void MovementSystem::updateSpeed(const Entity &entity) {
+		if (entity.movementSystem == this)
+			speeds[entity.movementSlot] = entity.getSpeed();
+	}
+
+	void MovementSystem::updatePath(const Entity &entity) {
+		if (entity.movementSystem == this)
+			nextAxes[entity.movementSlot] = getNextAxis(entity);
+	}
+
+	void MovementSystem::followPaths() {
+		// Taking a step can move an entity to another realm, which takes it out of this system and fills its slot with
+		// another entity, so the entities are gathered before any of them moves.
+		ready.clear();
+		for (size_t slot = 0, count = owners.size(); slot < count; ++slot) {
+			const Axis axis = nextAxes[slot];
+			if ((axis == HORIZONTAL && offsetX[slot] == 0.f) || (axis == VERTICAL && offsetY[slot] == 0.f))
+				ready.push_back(owners[slot]);
+		}
+
+		for (Entity *entity: ready)
+			if (entity->movementSystem == this)
+				entity->followPath();
+	}
+
+	MovementSystem::Axis MovementSystem::getNextAxis(const Entity &entity) {
+		if (!entity.hasPath())
+			return NONE;
+		switch (entity.getPath().front()) {
+			case Direction::Left:
+			case Direction::Right:
+				return HORIZONTAL;
+			default:
+				return VERTICAL;
+		}
+	}
+
+	void MovementSystem::ease(float delta) {
+		const Eigen::Index count = owners.size();
+		if (count == 0)
+			return;
+
+		Eigen::Map<Eigen::ArrayXf> x(offsetX.data(), count);
+		Eigen::Map<Eigen::ArrayXf> y(offsetY.data(), count);
+		const Eigen::Map<const Eigen::ArrayXf> speed(speeds.data(), count);
+
+		// sign(v) * max(|v| - distance, 0) moves v toward zero without overshooting, with no per-element branches.
+		x = x.sign() * (x.abs() - speed * delta).max(0.f);
+		y = y.sign() * (y.abs() - speed * delta).max(0.f);
+	}
+}
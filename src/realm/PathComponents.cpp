@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <utility>
+
+#include "realm/PathComponents.h"
+#include "realm/PathMap.h"
+#include "util/Parallel.h"
+
+namespace Game3 {
+	void PathComponents::rebuild(const PathMap &path_map, Index width_, Index height_) {
+		width  = width_;
+		height = height_;
+		const Index area = width * height;
+
+		std::vector<Label> parents(area);
+		std::iota(parents.begin(), parents.end(), Label(0));
+
+		// Roots are always the smallest index in their set, which keeps the final labels deterministic.
+		auto find = [&](Label index) {
+			while (parents[index] != index)
+				index = parents[index] = parents[parents[index]];
+			return index;
+		};
+
+		auto unite = [&](Label first, Label second) {
+			first  = find(first);
+			second = find(second);
+			if (first == second)
+				return;
+			if (first < second)
+				parents[second] = first;
+			else
+				parents[first] = second;
+		};
+
+		// Each band only joins positions within itself, so bands never write to each other's parents.
+		const size_t band_count = (height + BAND_ROWS - 1) / BAND_ROWS;
+		parallelFor(band_count, [&](size_t band) {
+			const Index row_begin = band * BAND_ROWS;
+			const Index row_end   = std::min(height, row_begin + BAND_ROWS);
+			for (Index row = row_begin; row < row_end; ++row) {
+				for (Index column = 0; column < width; ++column) {
+					const Index index = row * width + column;
+					if (!path_map[index])
+						continue;
+					if (0 < column && path_map[index - 1])
+						unite(index, index - 1);
+					if (row_begin < row && path_map[index - width])
+						unite(index, index - width);
+				}
+			}
+		});
+
+		for (size_t band = 1; band < band_count; ++band) {
+			const Index row = band * BAND_ROWS;
+			for (Index column = 0; column < width; ++column) {
+				const Index index = row * width + column;
+				if (path_map[index] && path_map[index - width])
+					unite(index, index - width);
+			}
+		}
+
+		labels.assign(area, NONE);
+		parallelFor(band_count, [&](size_t band) {
+			const Index begin = band * BAND_ROWS * width;
+			const Index end   = std::min(area, begin + BAND_ROWS * width);
+			for (Index index = begin; index < end; ++index) {
+				if (!path_map[index])
+					continue;
+				// No path compression here: other threads are reading the same parents.
+				Label root = index;
+				while (parents[root] != root)
+					root = parents[root];
+				labels[index] = root + 1;
+			}
+		});
+
+		sizes.assign(area + 1, 0);
+		freeLabels.clear();
+		for (const Label label: labels)
+			++sizes[label];
+		sizes[NONE] = 0;
+	}
+
+	void PathComponents::update(const PathMap &path_map, Index index) {
+		const Position position(index / width, index % width);
+		const uint8_t neighbor_bits = path_map.getNeighbors(position);
+
+		std::array<Index, 4> neighbors;
+		size_t neighbor_count = 0;
+		if (neighbor_bits & PathMap::UP)
+			neighbors[neighbor_count++] = index - width;
+		if (neighbor_bits & PathMap::LEFT)
+			neighbors[neighbor_count++] = index - 1;
+		if (neighbor_bits & PathMap::RIGHT)
+			neighbors[neighbor_count++] = index + 1;
+		if (neighbor_bits & PathMap::DOWN)
+			neighbors[neighbor_count++] = index + width;
+
+		if (path_map[index]) {
+			if (neighbor_count == 0) {
+				const Label label = makeLabel();
+				labels[index] = label;
+				sizes[label] = 1;
+				return;
+			}
+
+			// The position joins its neighbors' components together. The largest of them keeps its label and the others
+			// are relabeled into it, so no position is relabeled by more than a logarithmic number of merges.
+			Label largest = labels[neighbors[0]];
+			for (size_t i = 1; i < neighbor_count; ++i)
+				if (sizes[largest] < sizes[labels[neighbors[i]]])
+					largest = labels[neighbors[i]];
+
+			labels[index] = largest;
+			++sizes[largest];
+			for (size_t i = 0; i < neighbor_count; ++i) {
+				const Label label = labels[neighbors[i]];
+				if (label != largest) {
+					sizes[largest] += fill(path_map, neighbors[i], largest);
+					releaseLabel(label);
+				}
+			}
+			return;
+		}
+
+		const Label old_label = labels[index];
+		labels[index] = NONE;
+		if (old_label == NONE)
+			return;
+		--sizes[old_label];
+
+		if (neighbor_count <= 1 || ringConnects(path_map, position)) {
+			if (sizes[old_label] == 0)
+				releaseLabel(old_label);
+			return;
+		}
+
+		// The component might have split. Each neighbor that a previous fill didn't reach is in a piece that gets a new
+		// label, except the last one: whatever still has the old label by then is all connected to it.
+		for (size_t i = 0; i + 1 < neighbor_count; ++i) {
+			if (labels[neighbors[i]] != old_label)
+				continue;
+			const Label label = makeLabel();
+			sizes[label] = fill(path_map, neighbors[i], label);
+			sizes[old_label] -= sizes[label];
+		}
+
+		if (sizes[old_label] == 0)
+			releaseLabel(old_label);
+	}
+
+	PathComponents::Label PathComponents::makeLabel() {
+		if (!freeLabels.empty()) {
+			const Label label = freeLabels.back();
+			freeLabels.pop_back();
+			return label;
+		}
+		sizes.push_back(0);
+		return sizes.size() - 1;
+	}
+
+	void PathComponents::releaseLabel(Label label) {
+		sizes[label] = 0;
+		freeLabels.push_back(label);
+	}
+
+	Index PathComponents::fill(const PathMap &path_map, Index start, Label label) {
+		std::vector<Index> stack {start};
+		labels[start] = label;
+		Index filled = 1;
+
+		auto visit = [&](bool pathable, Index next) {
+			if (pathable && labels[next] != label) {
+				labels[next] = label;
+				stack.push_back(next);
+				++filled;
+			}
+		};
+
+		while (!stack.empty()) {
+			const Index index = stack.back();
+			stack.pop_back();
+			const uint8_t neighbors = path_map.getNeighbors({index / width, index % width});
+			visit(neighbors & PathMap::UP,    index - width);
+			visit(neighbors & PathMap::LEFT,  index - 1);
+			visit(neighbors & PathMap::RIGHT, index + 1);
+			visit(neighbors & PathMap::DOWN,  index + width);
+		}
+
+		return filled;
+	}
+
+	bool PathComponents::ringConnects(const PathMap &path_map, const Position &position) const {
+		// Clockwise from the top. Consecutive positions are orthogonally adjacent to each other, and the orthogonal
+		// neighbors of the center are at the even indices.
+		constexpr std::array<std::pair<Index, Index>, 8> offsets {{{-1, 0}, {-1, 1}, {0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1}}};
+
+		std::array<bool, 8> pathable;
+		size_t gap = offsets.size();
+		for (size_t i = 0; i < offsets.size(); ++i) {
+			const Index row    = position.row    + offsets[i].first;
+			const Index column = position.column + offsets[i].second;
+			pathable[i] = 0 <= row && row < height && 0 <= column && column < width && path_map[row * width + column];
+			if (!pathable[i])
+				gap = i;
+		}
+
+		if (gap == offsets.size())
+			return true;
+
+		// Walk around the ring from an unpathable position and count the runs of pathable positions that contain an
+		// orthogonal neighbor.
+		size_t runs = 0;
+		bool in_run = false;
+		bool counted = false;
+		for (size_t step = 1; step <= offsets.size(); ++step) {
+			const size_t i = (gap + step) % offsets.size();
+			if (!pathable[i]) {
+				in_run = false;
+				continue;
+			}
+			if (!in_run) {
+				in_run = true;
+				counted = false;
+			}
+			if (i % 2 == 0 && !counted) {
+				counted = true;
+				++runs;
+			}
+		}
+
+		return runs <= 1;
+	}
+}
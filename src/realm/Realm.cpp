@@ -1,8 +1,13 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <iostream>
 #include <thread>
 #include <unordered_set>
+#include <utility>
 
 #include "MarchingSquares.h"
+#include "ThreadContext.h"
 #include "Tileset.h"
 #include "biome/Biome.h"
 #include "entity/Entity.h"
@@ -15,6 +20,8 @@
 #include "ui/Canvas.h"
 #include "ui/MainWindow.h"
 #include "ui/SpriteRenderer.h"
+#include "util/Parallel.h"
+#include "util/ThreadPool.h"
 #include "util/Timer.h"
 #include "util/Util.h"
 #include "worldgen/Carpet.h"
@@ -33,25 +40,35 @@ namespace Game3 {
 		tilemap1->init(game);
 		tilemap2->init(game);
 		tilemap3->init(game);
-		renderer1.init(tilemap1);
-		renderer2.init(tilemap2);
-		renderer3.init(tilemap3);
+		if (!game.isHeadless()) {
+			renderer1.init(tilemap1);
+			renderer2.init(tilemap2);
+			renderer3.init(tilemap3);
+		}
 		initTexture();
 		remakePathMap();
+		entityGrid.reset(getWidth(), getHeight());
+		tileEntitySlots.reset(getWidth(), getHeight());
 	}
 
 	Realm::Realm(Game &game_, RealmID id_, RealmType type_, TilemapPtr tilemap1_, BiomeMapPtr biome_map, int seed_):
 	id(id_), type(type_), tilemap1(std::move(tilemap1_)), biomeMap(std::move(biome_map)), seed(seed_), game(game_) {
 		tilemap1->init(game);
-		renderer1.init(tilemap1);
 		tilemap2 = std::make_shared<Tilemap>(tilemap1->width, tilemap1->height, tilemap1->tileSize, tilemap1->tileset);
 		tilemap3 = std::make_shared<Tilemap>(tilemap1->width, tilemap1->height, tilemap1->tileSize, tilemap1->tileset);
+		tilemap2->setLayout(tilemap1->getLayout());
+		tilemap3->setLayout(tilemap1->getLayout());
 		initTexture();
 		tilemap2->init(game);
 		tilemap3->init(game);
-		renderer2.init(tilemap2);
-		renderer3.init(tilemap3);
+		if (!game.isHeadless()) {
+			renderer1.init(tilemap1);
+			renderer2.init(tilemap2);
+			renderer3.init(tilemap3);
+		}
 		remakePathMap();
+		entityGrid.reset(getWidth(), getHeight());
+		tileEntitySlots.reset(getWidth(), getHeight());
 	}
 
 	void Realm::initTexture() {}
@@ -67,6 +84,7 @@ namespace Game3 {
 
 	void Realm::absorbJSON(const nlohmann::json &json) {
 		auto shared = shared_from_this();
+		ObjectPool::Scope pool_scope(objectPool);
 		id = json.at("id");
 		type = json.at("type");
 		seed = json.at("seed");
@@ -77,28 +95,42 @@ namespace Game3 {
 		tilemap2->init(game);
 		tilemap3->init(game);
 		initTexture();
+		tileEntitySlots.reset(getWidth(), getHeight());
 		biomeMap = std::make_shared<BiomeMap>(json.at("biomeMap"));
 		outdoors = json.at("outdoors");
 		for (const auto &[index, tile_entity_json]: json.at("tileEntities").get<std::unordered_map<std::string, nlohmann::json>>()) {
 			auto tile_entity = TileEntity::fromJSON(game, tile_entity_json);
-			tileEntities.emplace(parseUlong(index), tile_entity);
+			const Index parsed_index = parseUlong(index);
+			tileEntities.emplace(parsed_index, tile_entity);
+			tileEntityIndex.insert(parsed_index, tile_entity);
+			tileEntitySlots.set(parsed_index, tile_entity);
 			tile_entity->setRealm(shared);
+			tile_entity->markUpdated();
+			awakeTileEntities.insert(tile_entity);
 			tile_entity->onSpawn();
 			if (tile_entity_json.at("id").get<Identifier>() == "base:te/ghost"_id)
 				++ghostCount;
 		}
-		renderer1.init(tilemap1);
-		renderer2.init(tilemap2);
-		renderer3.init(tilemap3);
+		if (!game.isHeadless()) {
+			renderer1.init(tilemap1);
+			renderer2.init(tilemap2);
+			renderer3.init(tilemap3);
+		}
+		movement.clear();
 		entities.clear();
-		for (const auto &entity_json: json.at("entities"))
-			(*entities.insert(Entity::fromJSON(game, entity_json)).first)->setRealm(shared);
+		entityGrid.reset(getWidth(), getHeight());
+		for (const auto &entity_json: json.at("entities")) {
+			auto entity = *entities.insert(Entity::fromJSON(game, entity_json)).first;
+			entity->setRealm(shared);
+			entityGrid.insert(entity);
+			movement.add(*entity);
+		}
 		if (json.contains("extra"))
 			extraData = json.at("extra");
 	}
 
 	void Realm::render(const int width, const int height, const Eigen::Vector2f &center, float scale, SpriteRenderer &sprite_renderer, float game_time) {
-		Canvas &canvas = game.canvas;
+		Canvas &canvas = *game.canvas;
 		// auto &textureA = canvas.textureA;
 		// auto &textureB = canvas.textureB;
 		// auto &fbo = canvas.fbo;
@@ -198,11 +230,15 @@ namespace Game3 {
 	}
 
 	void Realm::reupload() {
+		if (0 < neighborBatchDepth) {
+			reuploadPending = true;
+			return;
+		}
 		getGame().activateContext();
 		renderer1.reupload();
 		renderer2.reupload();
 		renderer3.reupload();
-}
+	}
 
 	void Realm::rebind() {
 		renderer1.tilemap = tilemap1;
@@ -211,26 +247,51 @@ namespace Game3 {
 	}
 
 	EntityPtr Realm::add(const EntityPtr &entity) {
+		if (isDeferring()) {
+			// The entity might belong to a realm that's ticking on another thread, so it isn't touched until then.
+			defer([self = shared_from_this(), entity] { self->add(entity); });
+			return entity;
+		}
 		entity->setRealm(shared_from_this());
-		entities.insert(entity);
+		if (entities.insert(entity).second) {
+			entityGrid.insert(entity);
+			movement.add(*entity);
+			journal.recordEntity(RealmJournal::EventType::EntityAdded, entity, entity->position);
+		}
 		return entity;
 	}
 
 	TileEntityPtr Realm::addUnsafe(const TileEntityPtr &tile_entity) {
+		if (isDeferring()) {
+			defer([self = shared_from_this(), tile_entity] { self->addUnsafe(tile_entity); });
+			return tile_entity;
+		}
 		const Index index = getIndex(tile_entity->position);
 		if (tileEntities.contains(index))
 			return nullptr;
 		tile_entity->setRealm(shared_from_this());
+		tile_entity->markUpdated();
 		tileEntities.emplace(index, tile_entity);
-		if (tile_entity->solid)
-			pathMap[index] = false;
-		if (tile_entity->is("base:te/ghost"))
+		tileEntityIndex.insert(index, tile_entity);
+		tileEntitySlots.set(index, tile_entity);
+		awakeTileEntities.insert(tile_entity);
+		journal.recordTileEntity(RealmJournal::EventType::TileEntityAdded, tile_entity);
+		if (tile_entity->solid) {
+			setPathable(index, false);
+			if (!cells.empty())
+				cells[index].setSolidTileEntity(true);
+		}
+		if (tile_entity->is("base:te/ghost"_id))
 			++ghostCount;
 		tile_entity->onSpawn();
 		return tile_entity;
 	}
 
 	TileEntityPtr Realm::add(const TileEntityPtr &tile_entity) {
+		if (isDeferring()) {
+			defer([self = shared_from_this(), tile_entity] { self->add(tile_entity); });
+			return tile_entity;
+		}
 		auto lock = tileEntityLock.lockWrite(std::chrono::milliseconds(1));
 		return addUnsafe(tile_entity);
 	}
@@ -240,19 +301,57 @@ namespace Game3 {
 			entity->setRealm(shared_from_this());
 	}
 
+	Realm::Activity Realm::getActivity() const {
+		if (game.activeRealm.get() == this)
+			return Activity::Full;
+		for (const auto &entity: entities)
+			if (entity->isBusy())
+				return Activity::Full;
+		return Activity::Idle;
+	}
+
+	void Realm::update(float delta) {
+		if (getActivity() == Activity::Full) {
+			if (0.f < skippedTime)
+				catchUp(std::exchange(skippedTime, 0.f));
+			tick(delta);
+		} else if (IDLE_TICK_INTERVAL <= (skippedTime += delta)) {
+			catchUp(std::exchange(skippedTime, 0.f));
+		}
+	}
+
 	void Realm::tick(float delta) {
+		simulate(delta, false);
+	}
+
+	void Realm::catchUp(float delta) {
+		simulate(delta, true);
+	}
+
+	void Realm::simulate(float delta, bool catch_up) {
+		ObjectPool::Scope pool_scope(objectPool);
 		ticking = true;
-		for (auto &entity: entities)
-			if (entity->isPlayer()) {
-				auto player = std::dynamic_pointer_cast<Player>(entity);
-				if (!player->ticked) {
-					player->ticked = true;
-					player->tick(game, delta);
-				}
-			} else
-				entity->tick(game, delta);
-		for (auto &[index, tile_entity]: tileEntities)
-			tile_entity->tick(game, delta);
+		simulatedTime.store(simulatedTime.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+		wakeDueTileEntities();
+		tickingTileEntities.assign(awakeTileEntities.begin(), awakeTileEntities.end());
+		if (parallelTick) {
+			tickParallel(delta, catch_up);
+		} else {
+			for (auto &entity: entities)
+				if (entity->isPlayer())
+					tickPlayer(entity, delta);
+				else if (catch_up)
+					entity->catchUp(game, delta);
+				else
+					entity->tick(game, delta);
+			for (const auto &tile_entity: tickingTileEntities)
+				tile_entity->tick(game, delta);
+		}
+		// Catching up already walks as much of each path as the skipped time allows.
+		if (!catch_up)
+			movement.followPaths();
+		movement.ease(delta);
+		sleepTickedTileEntities();
 		ticking = false;
 		for (const auto &entity: entityRemovalQueue)
 			remove(entity);
@@ -260,62 +359,209 @@ namespace Game3 {
 		for (const auto &tile_entity: tileEntityRemovalQueue)
 			remove(tile_entity);
 		tileEntityRemovalQueue.clear();
+		journal.commit();
 	}
 
-	std::vector<EntityPtr> Realm::findEntities(const Position &position) const {
-		std::vector<EntityPtr> out;
+	void Realm::tickParallel(float delta, bool catch_up) {
+		const Index region_rows    = std::max<Index>(1, (getHeight() + TICK_REGION_SIZE - 1) / TICK_REGION_SIZE);
+		const Index region_columns = std::max<Index>(1, (getWidth()  + TICK_REGION_SIZE - 1) / TICK_REGION_SIZE);
+
+		// The regions are normally emptied at the end of the previous tick, but not if it threw.
+		for (auto &region: tickRegions) {
+			region.entities.clear();
+			region.tileEntities.clear();
+			region.commands.clear();
+		}
+		tickRegions.resize(region_rows * region_columns);
+
+		auto get_region = [&](const Position &position) -> TickRegion & {
+			const Index row    = std::clamp<Index>(position.row    / TICK_REGION_SIZE, 0, region_rows    - 1);
+			const Index column = std::clamp<Index>(position.column / TICK_REGION_SIZE, 0, region_columns - 1);
+			return tickRegions[row * region_columns + column];
+		};
+
+		// Players are ticked on this thread first because they interact with the UI.
+		std::vector<EntityPtr> players;
 		for (const auto &entity: entities)
-			if (entity->position == position)
-				out.push_back(entity);
-		return out;
+			if (entity->isPlayer())
+				players.push_back(entity);
+			else
+				get_region(entity->position).entities.push_back(entity);
+		for (const auto &tile_entity: tickingTileEntities)
+			get_region(tile_entity->position).tileEntities.push_back(tile_entity);
+		for (const auto &player: players)
+			tickPlayer(player, delta);
+
+		// Regions with the same row parity and column parity are at least one region apart, so each of these four
+		// batches can be ticked concurrently without two threads touching neighboring tiles.
+		std::vector<size_t> batch;
+		for (Index parity = 0; parity < 4; ++parity) {
+			batch.clear();
+			for (Index row = parity / 2; row < region_rows; row += 2)
+				for (Index column = parity % 2; column < region_columns; column += 2) {
+					const size_t region_index = row * region_columns + column;
+					const auto &region = tickRegions[region_index];
+					if (!region.entities.empty() || !region.tileEntities.empty())
+						batch.push_back(region_index);
+				}
+
+			game.getTickPool().run(batch.size(), [&](size_t batch_index) {
+				auto &region = tickRegions[batch[batch_index]];
+				ObjectPool::Scope pool_scope(objectPool);
+				threadContext.commandBuffer = &region.commands;
+				try {
+					for (const auto &entity: region.entities)
+						if (catch_up)
+							entity->catchUp(game, delta);
+						else
+							entity->tick(game, delta);
+					for (const auto &tile_entity: region.tileEntities)
+						tile_entity->tick(game, delta);
+				} catch (...) {
+					threadContext.commandBuffer = nullptr;
+					throw;
+				}
+				threadContext.commandBuffer = nullptr;
+			});
+		}
+
+		// Applying the deferred changes in region order makes the result independent of how the threads were scheduled.
+		for (auto &region: tickRegions) {
+			for (auto &command: region.commands)
+				command();
+			region.commands.clear();
+			region.entities.clear();
+			region.tileEntities.clear();
+		}
+	}
+
+	void Realm::wakeDueTileEntities() {
+		while (!sleepingTileEntities.empty() && sleepingTileEntities.top().wakeTime <= simulatedTime) {
+			auto tile_entity = sleepingTileEntities.top().tileEntity.lock();
+			sleepingTileEntities.pop();
+			if (!tile_entity)
+				continue;
+			// Skip tile entities that have been removed from this realm.
+			if (auto iter = tileEntities.find(getIndex(tile_entity->position)); iter == tileEntities.end() || iter->second != tile_entity)
+				continue;
+			const double wake_time = tile_entity->getWakeTime();
+			if (simulatedTime < wake_time) {
+				// Its wake time was pushed back while it slept.
+				if (wake_time != INFINITY)
+					sleepingTileEntities.push({wake_time, tile_entity});
+				continue;
+			}
+			awakeTileEntities.insert(tile_entity);
+		}
+	}
+
+	void Realm::sleepTickedTileEntities() {
+		for (const auto &tile_entity: tickingTileEntities) {
+			const double wake_time = tile_entity->getWakeTime();
+			if (simulatedTime < wake_time && awakeTileEntities.erase(tile_entity) != 0 && wake_time != INFINITY)
+				sleepingTileEntities.push({wake_time, tile_entity});
+		}
+		tickingTileEntities.clear();
+	}
+
+	void Realm::reclaimTileEntities() {
+		tileEntitySlots.reclaim();
+	}
+
+	void Realm::wakeTileEntity(const TileEntityPtr &tile_entity) {
+		if (isDeferring())
+			return defer([self = shared_from_this(), tile_entity] { self->wakeTileEntity(tile_entity); });
+		if (auto iter = tileEntities.find(getIndex(tile_entity->position)); iter != tileEntities.end() && iter->second == tile_entity)
+			awakeTileEntities.insert(tile_entity);
+	}
+
+	void Realm::tickPlayer(const EntityPtr &entity, float delta) {
+		auto player = std::dynamic_pointer_cast<Player>(entity);
+		if (!player->ticked) {
+			player->ticked = true;
+			player->tick(game, delta);
+		}
+	}
+
+	std::vector<EntityPtr> Realm::findEntities(const Position &position) const {
+		return entityGrid.find(position);
 	}
 
 	std::vector<EntityPtr> Realm::findEntities(const Position &position, const EntityPtr &except) const {
 		std::vector<EntityPtr> out;
-		for (const auto &entity: entities)
-			if (entity->position == position && entity != except)
+		entityGrid.visit(TileRect{position.row, position.column, 1, 1}, [&](const EntityPtr &entity) {
+			if (entity != except)
 				out.push_back(entity);
+			return false;
+		});
 		return out;
 	}
 
 	EntityPtr Realm::findEntity(const Position &position) const {
-		for (const auto &entity: entities)
-			if (entity->position == position)
-				return entity;
-		return {};
+		EntityPtr out;
+		entityGrid.visit(TileRect{position.row, position.column, 1, 1}, [&](const EntityPtr &entity) {
+			out = entity;
+			return true;
+		});
+		return out;
 	}
 
 	EntityPtr Realm::findEntity(const Position &position, const EntityPtr &except) const {
-		for (const auto &entity: entities)
-			if (entity->position == position && entity != except)
-				return entity;
-		return {};
+		EntityPtr out;
+		entityGrid.visit(TileRect{position.row, position.column, 1, 1}, [&](const EntityPtr &entity) {
+			if (entity == except)
+				return false;
+			out = entity;
+			return true;
+		});
+		return out;
+	}
+
+	std::vector<EntityPtr> Realm::findEntities(const TileRect &rect) const {
+		return entityGrid.find(rect);
+	}
+
+	std::vector<EntityPtr> Realm::findEntities(const Position &center, double radius) const {
+		return entityGrid.find(center, radius);
 	}
 
 	TileEntityPtr Realm::tileEntityAt(const Position &position) {
-		auto lock = tileEntityLock.lockRead();
-		if (auto iter = tileEntities.find(getIndex(position)); iter != tileEntities.end())
-			return iter->second;
-		return {};
+		return tileEntitySlots.get(getIndex(position));
 	}
 
 	void Realm::remove(EntityPtr entity) {
-		entities.erase(entity);
+		if (isDeferring())
+			return defer([self = shared_from_this(), entity] { self->remove(entity); });
+		if (entities.erase(entity) != 0) {
+			entityGrid.remove(entity);
+			movement.remove(*entity);
+			journal.recordEntity(RealmJournal::EventType::EntityRemoved, entity, entity->position);
+		}
 	}
 
 	void Realm::remove(const TileEntityPtr &tile_entity, bool run_helper) {
+		if (isDeferring())
+			return defer([self = shared_from_this(), tile_entity, run_helper] { self->remove(tile_entity, run_helper); });
 		const Position position = tile_entity->position;
 		const Index index = getIndex(position);
 		tileEntities.at(index)->onRemove();
+		tileEntityIndex.remove(index, tileEntities.at(index));
+		tileEntitySlots.erase(index, tileEntities.at(index));
+		awakeTileEntities.erase(tileEntities.at(index));
 		tileEntities.erase(index);
+		journal.recordTileEntity(RealmJournal::EventType::TileEntityRemoved, tile_entity);
+		if (!cells.empty())
+			cells[index].setSolidTileEntity(false);
 		if (run_helper)
-			setLayerHelper(index, false);
-		if (tile_entity->is("base:te/ghost"))
+			setLayerHelper(index);
+		if (tile_entity->is("base:te/ghost"_id))
 			--ghostCount;
 		updateNeighbors(position);
 	}
 
 	void Realm::removeSafe(const TileEntityPtr &tile_entity) {
+		if (isDeferring())
+			return defer([self = shared_from_this(), tile_entity] { self->removeSafe(tile_entity); });
 		auto lock = tileEntityLock.lockWrite(std::chrono::milliseconds(1));
 		remove(tile_entity, false);
 	}
@@ -324,8 +570,12 @@ namespace Game3 {
 		return {index / getWidth(), index % getWidth()};
 	}
 
-	void Realm::onMoved(const EntityPtr &entity, const Position &position) {
-		if (auto tile_entity = tileEntityAt(position))
+	void Realm::onMoved(const EntityPtr &entity, const Position &old_position, const Position &new_position) {
+		if (isDeferring())
+			return defer([self = shared_from_this(), entity, old_position, new_position] { self->onMoved(entity, old_position, new_position); });
+		entityGrid.update(entity);
+		journal.recordEntity(RealmJournal::EventType::EntityMoved, entity, new_position, old_position);
+		if (auto tile_entity = tileEntityAt(new_position))
 			tile_entity->onOverlap(entity);
 	}
 
@@ -333,7 +583,31 @@ namespace Game3 {
 		return game;
 	}
 
+	void Realm::defer(std::function<void()> function) {
+		if (isDeferring())
+			threadContext.commandBuffer->push_back(std::move(function));
+		else
+			function();
+	}
+
+	void Realm::deferShared(std::function<void()> function) {
+		if (auto *buffer = threadContext.commandBuffer)
+			buffer->push_back(std::move(function));
+		else
+			function();
+	}
+
+	bool Realm::isTickingInParallel() {
+		return threadContext.commandBuffer != nullptr;
+	}
+
+	bool Realm::isDeferring() const {
+		return threadContext.commandBuffer != nullptr && threadContext.exclusiveRealm != this;
+	}
+
 	void Realm::queueRemoval(const EntityPtr &entity) {
+		if (isDeferring())
+			return defer([self = shared_from_this(), entity] { self->queueRemoval(entity); });
 		if (ticking)
 			entityRemovalQueue.push_back(entity);
 		else
@@ -341,6 +615,8 @@ namespace Game3 {
 	}
 
 	void Realm::queueRemoval(const TileEntityPtr &tile_entity) {
+		if (isDeferring())
+			return defer([self = shared_from_this(), tile_entity] { self->queueRemoval(tile_entity); });
 		if (ticking)
 			tileEntityRemovalQueue.push_back(tile_entity);
 		else
@@ -348,63 +624,85 @@ namespace Game3 {
 	}
 
 	void Realm::absorb(const EntityPtr &entity, const Position &position) {
+		// This changes the entity's old realm as well as this one.
+		if (isTickingInParallel())
+			return deferShared([self = shared_from_this(), entity, position] { self->absorb(entity, position); });
 		if (auto realm = entity->weakRealm.lock())
 			realm->remove(entity);
-		entity->setRealm(shared_from_this());
+		entity->position = position;
+		add(entity);
 		entity->init(getGame());
 		entity->teleport(position);
 	}
 
 	void Realm::setLayer1(Index row, Index column, TileID tile, bool run_helper) {
-		tilemap1->set(column, row, tile);
+		if (isDeferring())
+			return defer([self = shared_from_this(), row, column, tile, run_helper] { self->setLayer1(row, column, tile, run_helper); });
+		setTile(1, getIndex(row, column), tile);
 		if (run_helper)
 			setLayerHelper(row, column);
 	}
 
 	void Realm::setLayer2(Index row, Index column, TileID tile, bool run_helper) {
-		tilemap2->set(column, row, tile);
+		if (isDeferring())
+			return defer([self = shared_from_this(), row, column, tile, run_helper] { self->setLayer2(row, column, tile, run_helper); });
+		setTile(2, getIndex(row, column), tile);
 		if (run_helper)
 			setLayerHelper(row, column);
 	}
 
 	void Realm::setLayer3(Index row, Index column, TileID tile, bool run_helper) {
-		tilemap3->set(column, row, tile);
+		if (isDeferring())
+			return defer([self = shared_from_this(), row, column, tile, run_helper] { self->setLayer3(row, column, tile, run_helper); });
+		setTile(3, getIndex(row, column), tile);
 		if (run_helper)
 			setLayerHelper(row, column);
 	}
 
 	void Realm::setLayer1(Index index, TileID tile, bool run_helper) {
-		tilemap1->set(index, tile);
+		if (isDeferring())
+			return defer([self = shared_from_this(), index, tile, run_helper] { self->setLayer1(index, tile, run_helper); });
+		setTile(1, index, tile);
 		if (run_helper)
 			setLayerHelper(index);
 	}
 
 	void Realm::setLayer2(Index index, TileID tile, bool run_helper) {
-		tilemap2->set(index, tile);
+		if (isDeferring())
+			return defer([self = shared_from_this(), index, tile, run_helper] { self->setLayer2(index, tile, run_helper); });
+		setTile(2, index, tile);
 		if (run_helper)
 			setLayerHelper(index);
 	}
 
 	void Realm::setLayer3(Index index, TileID tile, bool run_helper) {
-		tilemap3->set(index, tile);
+		if (isDeferring())
+			return defer([self = shared_from_this(), index, tile, run_helper] { self->setLayer3(index, tile, run_helper); });
+		setTile(3, index, tile);
 		if (run_helper)
 			setLayerHelper(index);
 	}
 
 	void Realm::setLayer1(Index index, const Identifier &tilename, bool run_helper) {
-		tilemap1->set(index, (*tilemap1->tileset)[tilename]);
+		if (isDeferring())
+			return defer([self = shared_from_this(), index, tilename, run_helper] { self->setLayer1(index, tilename, run_helper); });
+		setTile(1, index, (*tilemap1->tileset)[tilename]);
 		if (run_helper)
 			setLayerHelper(index);
 	}
 
 	void Realm::setLayer2(Index index, const Identifier &tilename, bool run_helper) {
-		tilemap2->set(index, (*tilemap2->tileset)[tilename]);
+		if (isDeferring())
+			return defer([self = shared_from_this(), index, tilename, run_helper] { self->setLayer2(index, tilename, run_helper); });
+		setTile(2, index, (*tilemap2->tileset)[tilename]);
 		if (run_helper)
 			setLayerHelper(index);
 	}
 
 	void Realm::setLayer3(Index index, const Identifier &tilename, bool run_helper) {
-		tilemap3->set(index, (*tilemap3->tileset)[tilename]);
+		if (isDeferring())
+			return defer([self = shared_from_this(), index, tilename, run_helper] { self->setLayer3(index, tilename, run_helper); });
+		setTile(3, index, (*tilemap3->tileset)[tilename]);
 		if (run_helper)
 			setLayerHelper(index);
 	}
@@ -484,32 +782,19 @@ namespace Game3 {
 	}
 
 	std::optional<Position> Realm::getPathableAdjacent(const Position &position) const {
-		const auto width  = getWidth();
-		const auto height = getHeight();
+		const uint8_t neighbors = pathMap.getNeighbors(position);
 
-		if (position.row < height - 1) {
-			const Position next(position.row + 1, position.column);
-			if (pathMap[getIndex(next)])
-				return next;
-		}
+		if (neighbors & PathMap::DOWN)
+			return Position(position.row + 1, position.column);
 
-		if (position.column < width - 1) {
-			const Position next(position.row, position.column + 1);
-			if (pathMap[getIndex(next)])
-				return next;
-		}
+		if (neighbors & PathMap::RIGHT)
+			return Position(position.row, position.column + 1);
 
-		if (0 < position.row) {
-			const Position next(position.row - 1, position.column);
-			if (pathMap[getIndex(next)])
-				return next;
-		}
+		if (neighbors & PathMap::UP)
+			return Position(position.row - 1, position.column);
 
-		if (0 < position.column) {
-			const Position next(position.row, position.column - 1);
-			if (pathMap[getIndex(next)])
-				return next;
-		}
+		if (neighbors & PathMap::LEFT)
+			return Position(position.row, position.column - 1);
 
 		return std::nullopt;
 	}
@@ -523,55 +808,173 @@ namespace Game3 {
 	}
 
 	void Realm::updateNeighbors(const Position &position) {
-		static size_t depth = 0;
-		static bool layer2_updated = false;
-
-		++depth;
-
-		const auto &tiles = tilemap2->getTiles();
-		const auto &tileset = *tilemap2->tileset;
-
-		for (Index row_offset = -1; row_offset <= 1; ++row_offset)
-			for (Index column_offset = -1; column_offset <= 1; ++column_offset)
-				if (row_offset != 0 || column_offset != 0) {
-					const Position offset_position = position + Position(row_offset, column_offset);
-					if (!isValid(offset_position))
-						continue;
-					if (auto neighbor = tileEntityAt(offset_position)) {
-						neighbor->onNeighborUpdated(-row_offset, -column_offset);
-					} else {
-						const TileID tile = tiles.at(getIndex(offset_position));
-						const auto &tilename = tileset[tile];
-
-						for (const auto &category: tileset.getCategories(tilename)) {
-							if (tileset.isCategoryMarchable(category)) {
-								TileID march_result = march4([&](int8_t march_row_offset, int8_t march_column_offset) -> bool {
-									const Position march_position = offset_position + Position(march_row_offset, march_column_offset);
-									if (!isValid(march_position))
-										return false;
-									return tileset.isInCategory(tileset[tiles.at(getIndex(march_position))], category);
-								});
-
-								// ???
-								const TileID marched = (march_result / 7 + 6) * (tilemap2->setWidth / tilemap2->tileSize) + march_result % 7;
-								if (marched != tile) {
-									tilemap2->set(offset_position, marched);
-									layer2_updated = true;
-								}
-							}
-						}
-					}
+		if (isDeferring())
+			return defer([self = shared_from_this(), position] { self->updateNeighbors(position); });
+
+		pendingNeighborUpdates.push_back(getIndex(position));
+		if (neighborBatchDepth == 0)
+			flushNeighborUpdates();
+	}
+
+	void Realm::updateNeighbors(const TileRect &rect) {
+		if (isDeferring())
+			return defer([self = shared_from_this(), rect] { self->updateNeighbors(rect); });
+
+		const Index row_end    = std::min(rect.row    + rect.height, getHeight());
+		const Index column_end = std::min(rect.column + rect.width,  getWidth());
+		for (Index row = std::max<Index>(rect.row, 0); row < row_end; ++row)
+			for (Index column = std::max<Index>(rect.column, 0); column < column_end; ++column)
+				pendingNeighborUpdates.push_back(getIndex(row, column));
+		if (neighborBatchDepth == 0)
+			flushNeighborUpdates();
+	}
+
+	void Realm::flushNeighborUpdates() {
+		// Tile entities can update their own neighbors when notified. Those updates are queued and handled in later rounds.
+		++neighborBatchDepth;
+		std::vector<Index> changed;
+		while (!pendingNeighborUpdates.empty()) {
+			changed.swap(pendingNeighborUpdates);
+			marchNeighbors(changed);
+			changed.clear();
+		}
+		--neighborBatchDepth;
+
+		if (std::exchange(reuploadPending, false))
+			reupload();
+	}
+
+	void Realm::marchNeighbors(std::vector<Index> &changed) {
+		std::sort(changed.begin(), changed.end());
+		changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+		std::vector<Index> affected;
+		affected.reserve(changed.size() * 8);
+		for (const Index index: changed) {
+			const Position position = getPosition(index);
+			tilemap2->iterateNeighbors(position.column, position.row, [&](Index row_offset, Index column_offset, TileID) {
+				affected.push_back(getIndex(position.row + row_offset, position.column + column_offset));
+			});
+		}
+		std::sort(affected.begin(), affected.end());
+		affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+
+		std::vector<std::pair<Index, TileEntityPtr>> notified;
+		for (const Index index: affected)
+			if (auto tile_entity = tileEntitySlots.get(index))
+				notified.emplace_back(index, std::move(tile_entity));
+
+		auto &tilemap = *tilemap2;
+		const auto &tileset = *tilemap.tileset;
+		const Index set_columns = tilemap.setWidth / tilemap.tileSize;
+		auto notified_iter = notified.begin();
+
+		for (const Index index: affected) {
+			while (notified_iter != notified.end() && notified_iter->first < index)
+				++notified_iter;
+			if (notified_iter != notified.end() && notified_iter->first == index)
+				continue;
+
+			const Position position = getPosition(index);
+			const TileID tile = tilemap[position];
+			for (const auto &category: tileset.getCategories(tile)) {
+				if (!category->marchable)
+					continue;
+
+				const TileID march_result = march4([&](int8_t march_row_offset, int8_t march_column_offset) -> bool {
+					const Position march_position = position + Position(march_row_offset, march_column_offset);
+					if (!isValid(march_position))
+						return false;
+					return category->contains(tilemap[march_position]);
+				});
+
+				// ???
+				const TileID marched = (march_result / 7 + 6) * set_columns + march_result % 7;
+				if (marched != tile) {
+					tilemap.set(position, marched);
+					journal.recordTile(2, position);
+					updateCell(index);
 				}
+			}
+		}
 
-		if (--depth == 0 && layer2_updated) {
-			layer2_updated = false;
-			getGame().activateContext();
-			renderer2.reupload();
+		auto is_changed = [&](const Position &position) {
+			return isValid(position) && std::binary_search(changed.begin(), changed.end(), getIndex(position));
+		};
+
+		// Each tile entity is notified once, after the tiles around it have been marched. Orthogonal neighbors are checked
+		// first so that a tile entity hears about one of those if any of them changed.
+		constexpr std::array<std::pair<Index, Index>, 8> offsets {{{-1, 0}, {0, -1}, {0, 1}, {1, 0}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}}};
+		for (const auto &[index, tile_entity]: notified) {
+			const Position position = getPosition(index);
+			for (const auto &[row_offset, column_offset]: offsets)
+				if (is_changed(position + Position(row_offset, column_offset))) {
+					tile_entity->onNeighborUpdated(row_offset, column_offset);
+					break;
+				}
 		}
 	}
 
 	bool Realm::hasTileEntityAt(const Position &position) const {
-		return tileEntities.contains(getIndex(position));
+		return tileEntitySlots.contains(getIndex(position));
+	}
+
+	Realm::NeighborBatch::NeighborBatch(Realm &realm_): realm(realm_) {
+		++realm.neighborBatchDepth;
+	}
+
+	Realm::NeighborBatch::~NeighborBatch() {
+		if (--realm.neighborBatchDepth == 0)
+			realm.flushNeighborUpdates();
+	}
+
+	Realm::Transaction::Transaction(Realm &realm_): realm(realm_), neighborBatch(realm_) {
+		++realm.transactionDepth;
+	}
+
+	Realm::Transaction::~Transaction() {
+		if (--realm.transactionDepth == 0)
+			realm.commitTransaction();
+	}
+
+	void Realm::commitTransaction() {
+		const std::array<Tilemap *, 3> tilemaps {tilemap1.get(), tilemap2.get(), tilemap3.get()};
+		for (size_t layer = 0; layer < tilemaps.size(); ++layer) {
+			tilemaps[layer]->updateLava(transactionTiles[layer]);
+			transactionTiles[layer].clear();
+		}
+
+		if (transactionHelpers.empty())
+			return;
+
+		std::sort(transactionHelpers.begin(), transactionHelpers.end());
+		transactionHelpers.erase(std::unique(transactionHelpers.begin(), transactionHelpers.end()), transactionHelpers.end());
+
+		// Past a point, recomputing the whole area the transaction touched and relabeling everything at once is cheaper
+		// than updating the path components one position at a time.
+		if (pathMap.size() / 8 <= transactionHelpers.size()) {
+			const Index width = getWidth();
+			Index min_column = width;
+			Index max_column = 0;
+			for (const Index index: transactionHelpers) {
+				min_column = std::min(min_column, index % width);
+				max_column = std::max(max_column, index % width);
+			}
+			// The helpers are sorted, so the first and last ones have the lowest and highest rows.
+			const Index min_row = transactionHelpers.front() / width;
+			const Index max_row = transactionHelpers.back() / width;
+			updatePathMap({min_row, min_column, max_row - min_row + 1, max_column - min_column + 1});
+		} else {
+			const auto &tileset = getTileset();
+			for (const Index index: transactionHelpers) {
+				const Position position = getPosition(index);
+				setPathable(index, isWalkable(position.row, position.column, tileset));
+			}
+		}
+
+		// Marching happens when the transaction's NeighborBatch ends, right after this.
+		pendingNeighborUpdates.insert(pendingNeighborUpdates.end(), transactionHelpers.begin(), transactionHelpers.end());
+		transactionHelpers.clear();
 	}
 
 	void Realm::confirmGhosts() {
@@ -580,17 +983,16 @@ namespace Game3 {
 
 		std::vector<std::shared_ptr<Ghost>> ghosts;
 
-		for (auto &[index, tile_entity]: tileEntities)
-			if (tile_entity->is("base:te/ghost"))
-				ghosts.push_back(std::dynamic_pointer_cast<Ghost>(tile_entity));
+		iterateTileEntities<Ghost>([&](const std::shared_ptr<Ghost> &ghost) {
+			ghosts.push_back(ghost);
+			return false;
+		});
 
+		NeighborBatch batch(*this);
 		for (const auto &ghost: ghosts) {
 			remove(ghost);
 			ghost->confirm();
 		}
-
-		game.activateContext();
-		renderer2.reupload();
 	}
 
 	void Realm::damageGround(const Position &position) {
@@ -605,13 +1007,13 @@ namespace Game3 {
 		return *tilemap1->tileset;
 	}
 
-	void Realm::toJSON(nlohmann::json &json) const {
+	void Realm::toJSON(nlohmann::json &json, int compression_level) const {
 		json["id"] = id;
 		json["type"] = type;
 		json["seed"] = seed;
-		json["tilemap1"] = *tilemap1;
-		json["tilemap2"] = *tilemap2;
-		json["tilemap3"] = *tilemap3;
+		tilemap1->toJSON(json["tilemap1"], compression_level);
+		tilemap2->toJSON(json["tilemap2"], compression_level);
+		tilemap3->toJSON(json["tilemap3"], compression_level);
 		json["biomeMap"] = *biomeMap;
 		json["outdoors"] = outdoors;
 		json["tileEntities"] = std::unordered_map<std::string, nlohmann::json>();
@@ -628,46 +1030,174 @@ namespace Game3 {
 	}
 
 	bool Realm::isWalkable(Index row, Index column, const Tileset &tileset) const {
+		if (!cells.empty())
+			return cells[getIndex(row, column)].isPathable();
 		if (!tileset.isWalkable((*tilemap1)(column, row)) || !tileset.isWalkable((*tilemap2)(column, row)) || !tileset.isWalkable((*tilemap3)(column, row)))
 			return false;
-		const Index index = getIndex(row, column);
-		if (tileEntities.contains(index) && tileEntities.at(index)->solid)
+		if (auto iter = tileEntities.find(getIndex(row, column)); iter != tileEntities.end() && iter->second->solid)
 			return false;
 		return true;
 	}
 
-	void Realm::setLayerHelper(Index row, Index column, bool should_mark_dirty) {
+	void Realm::setTile(uint8_t layer, Index index, TileID tile) {
+		auto &tilemap = layer == 1? *tilemap1 : layer == 2? *tilemap2 : *tilemap3;
+		if (transactionDepth == 0) {
+			tilemap.set(index, tile);
+		} else {
+			tilemap.setUnsafe(index, tile);
+			if (tilemap.lavaQuadtree)
+				transactionTiles[layer - 1].push_back(index);
+		}
+		journal.recordTile(layer, getPosition(index));
+		updateCell(index);
+	}
+
+	void Realm::setLayerHelper(Index row, Index column) {
+		if (0 < transactionDepth) {
+			transactionHelpers.push_back(getIndex(row, column));
+			return;
+		}
 		const auto &tileset = getTileset();
 		const Position position(row, column);
-		pathMap[getIndex(position)] = isWalkable(row, column, tileset);
+		setPathable(getIndex(position), isWalkable(row, column, tileset));
 		updateNeighbors(position);
-		if (should_mark_dirty) {
-			renderer1.markDirty();
-			renderer2.markDirty();
-			renderer3.markDirty();
-		}
 	}
 
-	void Realm::setLayerHelper(Index index, bool should_mark_dirty) {
+	void Realm::setLayerHelper(Index index) {
+		if (0 < transactionDepth) {
+			transactionHelpers.push_back(index);
+			return;
+		}
 		const auto &tileset = getTileset();
 		const Position position = getPosition(index);
-		pathMap[index] = isWalkable(position.row, position.column, tileset);
+		setPathable(index, isWalkable(position.row, position.column, tileset));
 		updateNeighbors(position);
-		if (should_mark_dirty) {
-			renderer1.markDirty();
-			renderer2.markDirty();
-			renderer3.markDirty();
-		}
 	}
 
 	void Realm::remakePathMap() {
-		const auto width = tilemap1->width;
-		const auto height = tilemap1->height;
-		pathMap.resize(width * height);
+		const Index width = tilemap1->width;
+		pathMap.resize(width, tilemap1->height);
+
+		if (cellsEnabled) {
+			remakeCells();
+			pathMap.fillParallel([this](Index index) {
+				return cells[index].isPathable();
+			});
+		} else {
+			const auto &tileset = getTileset();
+			pathMap.fillParallel([&](Index index) {
+				return isWalkable(index / width, index % width, tileset);
+			});
+		}
+
+		pathComponents.rebuild(pathMap, width, tilemap1->height);
+	}
+
+	void Realm::updatePathMap(const TileRect &rect) {
+		const Index width = getWidth();
+		const Index row_end    = std::min(rect.row    + rect.height, getHeight());
+		const Index column_end = std::min(rect.column + rect.width,  width);
+		const Index column     = std::max<Index>(rect.column, 0);
+		if (column_end <= column)
+			return;
+
+		const auto &tileset = getTileset();
+		bool changed = false;
+		for (Index row = std::max<Index>(rect.row, 0); row < row_end; ++row)
+			pathMap.fill(getIndex(row, column), getIndex(row, column_end), [&](Index index) {
+				const bool walkable = isWalkable(row, index % width, tileset);
+				changed = changed || walkable != pathMap[index];
+				return walkable;
+			});
+
+		// PathComponents::update can only handle one change at a time.
+		if (changed)
+			pathComponents.rebuild(pathMap, width, getHeight());
+	}
+
+	void Realm::setPathable(Index index, bool pathable) {
+		if (pathMap[index] == pathable)
+			return;
+		pathMap.set(index, pathable);
+		pathComponents.update(pathMap, index);
+	}
+
+	PathComponents::Label Realm::getPathComponent(const Position &position) const {
+		if (pathComponents.empty() || !isValid(position))
+			return PathComponents::NONE;
+		return pathComponents[getIndex(position)];
+	}
+
+	bool Realm::isReachable(const Position &from, const Position &to) const {
+		if (!isValid(from) || !isValid(to))
+			return false;
+
+		// Until the path map has been made, assume anything could be reachable.
+		if (pathComponents.empty())
+			return true;
+
+		const PathComponents::Label goal = pathComponents[getIndex(to)];
+		if (goal == PathComponents::NONE)
+			return false;
+
+		const Index from_index = getIndex(from);
+		if (pathMap[from_index])
+			return pathComponents[from_index] == goal;
+
+		const uint8_t neighbors = pathMap.getNeighbors(from);
+		return ((neighbors & PathMap::UP)    && pathComponents[from_index - getWidth()] == goal)
+		    || ((neighbors & PathMap::LEFT)  && pathComponents[from_index - 1]          == goal)
+		    || ((neighbors & PathMap::RIGHT) && pathComponents[from_index + 1]          == goal)
+		    || ((neighbors & PathMap::DOWN)  && pathComponents[from_index + getWidth()] == goal);
+	}
+
+	std::optional<Position> Realm::getReachableAdjacent(const Position &position, const Position &from) const {
+		const uint8_t neighbors = pathMap.getNeighbors(position);
+		const std::array<std::pair<PathMap::Neighbor, Position>, 4> candidates {{
+			{PathMap::DOWN,  {position.row + 1, position.column}},
+			{PathMap::RIGHT, {position.row, position.column + 1}},
+			{PathMap::UP,    {position.row - 1, position.column}},
+			{PathMap::LEFT,  {position.row, position.column - 1}},
+		}};
+
+		for (const auto &[bit, candidate]: candidates)
+			if ((neighbors & bit) && isReachable(from, candidate))
+				return candidate;
+
+		return std::nullopt;
+	}
+
+	void Realm::setCellsEnabled(bool enabled) {
+		cellsEnabled = enabled;
+		if (enabled) {
+			remakeCells();
+		} else {
+			cells.clear();
+			cells.shrink_to_fit();
+		}
+	}
+
+	void Realm::updateCell(Index index) {
+		if (!cells.empty())
+			cells[index].update((*tilemap1)[index], (*tilemap2)[index], (*tilemap3)[index], getTileset());
+	}
+
+	void Realm::remakeCells() {
+		if (!cellsEnabled)
+			return;
+
 		const auto &tileset = getTileset();
-		for (Index row = 0; row < height; ++row)
+		const Index width = getWidth();
+		cells.assign(width * getHeight(), CellRecord());
+
+		parallelFor(getHeight(), [&](size_t row) {
 			for (Index column = 0; column < width; ++column)
-				pathMap[getIndex(row, column)] = isWalkable(row, column, tileset);
+				cells[row * width + column].update((*tilemap1)(column, row), (*tilemap2)(column, row), (*tilemap3)(column, row), tileset);
+		});
+
+		for (const auto &[index, tile_entity]: tileEntities)
+			if (tile_entity->solid)
+				cells[index].setSolidTileEntity(true);
 	}
 
 	bool Realm::rightClick(const Position &position, double x, double y) {
@@ -717,6 +1247,6 @@ namespace Game3 {
 	}
 
 	void to_json(nlohmann::json &json, const Realm &realm) {
-		realm.toJSON(json);
+		realm.toJSON(json, Tilemap::DEFAULT_COMPRESSION_LEVEL);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "container/TileChunk.h"
+#include "entity/Entity.h"
+#include "realm/RealmJournal.h"
+#include "tileentity/TileEntity.h"
+
+namespace Game3 {
+	std::shared_ptr<RealmJournal::Cursor> RealmJournal::subscribe() {
+		std::unique_lock lock(mutex);
+		auto cursor = std::make_shared<Cursor>();
+		cursor->next = nextSequence;
+		cursors.push_back(cursor);
+		active = true;
+		return cursor;
+	}
+
+	bool RealmJournal::read(Cursor &cursor, const std::function<void(const Entry &)> &visitor) {
+		std::vector<std::shared_ptr<const Entry>> unread;
+		bool was_lost = false;
+
+		{
+			std::unique_lock lock(mutex);
+			for (const auto &entry: history)
+				if (cursor.next <= entry->sequence)
+					unread.push_back(entry);
+			cursor.next = nextSequence;
+			was_lost = cursor.lost;
+			cursor.lost = false;
+			prune();
+		}
+
+		// The lock isn't held while visiting so that visitors can change the realm.
+		for (const auto &entry: unread)
+			visitor(*entry);
+
+		return !was_lost;
+	}
+
+	void RealmJournal::recordTile(uint8_t layer, Index row, Index column) {
+		if (!isActive())
+			return;
+
+		if (layer < 1 || 3 < layer)
+			throw std::invalid_argument("Invalid layer: " + std::to_string(layer));
+
+		const uint64_t key = (static_cast<uint64_t>(row >> TileChunk::SHIFT) << 32) | static_cast<uint32_t>(column >> TileChunk::SHIFT);
+
+		std::unique_lock lock(mutex);
+		auto &rects = pendingTiles[layer - 1];
+		if (auto iter = rects.find(key); iter != rects.end()) {
+			TileRect &rect = iter->second;
+			const Index bottom = std::max(rect.row + rect.height, row + 1);
+			const Index right  = std::max(rect.column + rect.width, column + 1);
+			rect.row    = std::min(rect.row, row);
+			rect.column = std::min(rect.column, column);
+			rect.height = bottom - rect.row;
+			rect.width  = right - rect.column;
+		} else {
+			rects.emplace(key, TileRect{row, column, 1, 1});
+		}
+		pendingEmpty = false;
+	}
+
+	void RealmJournal::recordTileEntity(EventType type, const std::shared_ptr<TileEntity> &tile_entity) {
+		if (!isActive())
+			return;
+
+		std::unique_lock lock(mutex);
+		pending.events.push_back(Event {
+			.type = type,
+			.position = tile_entity->position,
+			.oldPosition = {},
+			.entity = {},
+			.tileEntity = tile_entity,
+		});
+		pendingEmpty = false;
+	}
+
+	void RealmJournal::recordEntity(EventType type, const std::shared_ptr<Entity> &entity, const Position &position, const Position &old_position) {
+		if (!isActive())
+			return;
+
+		std::unique_lock lock(mutex);
+
+		if (type == EventType::EntityMoved) {
+			if (auto iter = pendingMoves.find(entity.get()); iter != pendingMoves.end()) {
+				pending.events[iter->second].position = position;
+				return;
+			}
+			pendingMoves.emplace(entity.get(), pending.events.size());
+		}
+
+		pending.events.push_back(Event {
+			.type = type,
+			.position = position,
+			.oldPosition = old_position,
+			.entity = entity,
+			.tileEntity = {},
+		});
+		pendingEmpty = false;
+	}
+
+	void RealmJournal::commit() {
+		if (!isActive())
+			return;
+
+		std::unique_lock lock(mutex);
+
+		if (pendingEmpty) {
+			prune();
+			return;
+		}
+
+		for (size_t layer = 0; layer < 3; ++layer) {
+			std::vector<std::pair<uint64_t, TileRect>> sorted(pendingTiles[layer].begin(), pendingTiles[layer].end());
+			std::sort(sorted.begin(), sorted.end(), [](const auto &left, const auto &right) { return left.first < right.first; });
+
+			// Join the boxes of horizontally adjacent chunks when they cover the same rows and meet in the middle.
+			auto &dirty = pending.dirtyTiles[layer];
+			for (const auto &[key, rect]: sorted) {
+				if (!dirty.empty()) {
+					TileRect &last = dirty.back();
+					if (last.row == rect.row && last.height == rect.height && last.column + last.width == rect.column) {
+						last.width += rect.width;
+						continue;
+					}
+				}
+				dirty.push_back(rect);
+			}
+		}
+
+		pending.sequence = nextSequence++;
+		history.push_back(std::make_shared<const Entry>(std::move(pending)));
+		clearPending();
+		prune();
+	}
+
+	void RealmJournal::clearPending() {
+		pending = {};
+		pendingEmpty = true;
+		for (auto &rects: pendingTiles)
+			rects.clear();
+		pendingMoves.clear();
+	}
+
+	void RealmJournal::prune() {
+		std::erase_if(cursors, [](const auto &weak_cursor) { return weak_cursor.expired(); });
+
+		if (cursors.empty()) {
+			active = false;
+			history.clear();
+			clearPending();
+			return;
+		}
+
+		uint64_t minimum = nextSequence;
+		for (const auto &weak_cursor: cursors)
+			if (auto cursor = weak_cursor.lock())
+				minimum = std::min(minimum, cursor->next);
+
+		while (!history.empty() && (history.front()->sequence < minimum || MAX_HISTORY < history.size()))
+			history.pop_front();
+
+		// Any cursor now pointing before the oldest remaining entry has lost entries to the history limit.
+		const uint64_t first_kept = history.empty()? nextSequence : history.front()->sequence;
+		for (const auto &weak_cursor: cursors)
+			if (auto cursor = weak_cursor.lock(); cursor && cursor->next < first_kept) {
+				cursor->next = first_kept;
+				cursor->lost = true;
+			}
+	}
+}
@@ -0,0 +1,63 @@
+#include "realm/TileEntityIndex.h"
+
+namespace Game3 {
+	void TileEntityIndex::insert(Index index, const std::shared_ptr<TileEntity> &tile_entity) {
+		auto &bucket = byType[std::type_index(typeid(*tile_entity))];
+		if (!bucket.members.emplace(index, tile_entity).second)
+			return;
+
+		const Index cell_row    = tile_entity->position.row    >> CELL_SHIFT;
+		const Index cell_column = tile_entity->position.column >> CELL_SHIFT;
+		bucket.cells[getCellKey(cell_row, cell_column)].push_back(tile_entity);
+		if (bucket.maxCellRow < bucket.minCellRow) {
+			bucket.minCellRow = bucket.maxCellRow = cell_row;
+			bucket.minCellColumn = bucket.maxCellColumn = cell_column;
+		} else {
+			bucket.minCellRow    = std::min(bucket.minCellRow,    cell_row);
+			bucket.maxCellRow    = std::max(bucket.maxCellRow,    cell_row);
+			bucket.minCellColumn = std::min(bucket.minCellColumn, cell_column);
+			bucket.maxCellColumn = std::max(bucket.maxCellColumn, cell_column);
+		}
+
+		byTileID[tile_entity->tileID].emplace(index, tile_entity);
+	}
+
+	void TileEntityIndex::remove(Index index, const std::shared_ptr<TileEntity> &tile_entity) {
+		if (auto iter = byType.find(std::type_index(typeid(*tile_entity))); iter != byType.end()) {
+			auto &bucket = iter->second;
+			if (auto member = bucket.members.find(index); member != bucket.members.end() && member->second == tile_entity) {
+				bucket.members.erase(member);
+				const uint64_t key = getCellKey(tile_entity->position.row >> CELL_SHIFT, tile_entity->position.column >> CELL_SHIFT);
+				if (auto cell_iter = bucket.cells.find(key); cell_iter != bucket.cells.end()) {
+					auto &cell = cell_iter->second;
+					if (auto found = std::find(cell.begin(), cell.end(), tile_entity); found != cell.end()) {
+						*found = std::move(cell.back());
+						cell.pop_back();
+					}
+					if (cell.empty())
+						bucket.cells.erase(cell_iter);
+				}
+			}
+			if (bucket.members.empty())
+				byType.erase(iter);
+		}
+
+		if (auto iter = byTileID.find(tile_entity->tileID); iter != byTileID.end()) {
+			iter->second.erase(index);
+			if (iter->second.empty())
+				byTileID.erase(iter);
+		}
+	}
+
+	void TileEntityIndex::clear() {
+		byType.clear();
+		byTileID.clear();
+	}
+
+	const TileEntityIndex::Bucket & TileEntityIndex::getByTileID(const Identifier &tile_id) const {
+		static const Bucket empty;
+		if (auto iter = byTileID.find(tile_id); iter != byTileID.end())
+			return iter->second;
+		return empty;
+	}
+}
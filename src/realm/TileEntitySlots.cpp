@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+#include "realm/TileEntitySlots.h"
+#include "tileentity/TileEntity.h"
+
+namespace Game3 {
+	namespace {
+		constexpr uint64_t IDLE = std::numeric_limits<uint64_t>::max();
+
+		/** Starts at 1 so that no retired tile entity can be tagged with an epoch that a reader could mistake for IDLE. */
+		std::atomic<uint64_t> globalEpoch = 1;
+
+		/** The epoch a thread pinned while it's reading a slot, or IDLE. */
+		struct ReaderRecord {
+			std::atomic<uint64_t> epoch = IDLE;
+		};
+
+		std::mutex readersMutex;
+		std::vector<ReaderRecord *> readers;
+
+		/** Registers the thread's record the first time the thread reads a slot and unregisters it when the thread exits. */
+		struct ReaderRegistration {
+			ReaderRecord record;
+
+			ReaderRegistration() {
+				std::unique_lock lock(readersMutex);
+				readers.push_back(&record);
+			}
+
+			~ReaderRegistration() {
+				std::unique_lock lock(readersMutex);
+				std::erase(readers, &record);
+			}
+		};
+
+		thread_local ReaderRegistration readerRegistration;
+
+		class Pin {
+			public:
+				Pin(): record(readerRegistration.record) {
+					record.epoch.store(globalEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+				}
+
+				~Pin() {
+					record.epoch.store(IDLE, std::memory_order_release);
+				}
+
+			private:
+				ReaderRecord &record;
+		};
+	}
+
+	void TileEntitySlots::reset(Index width, Index height) {
+		slotCount = width * height;
+		slots = std::make_unique<std::atomic<TileEntity *>[]>(slotCount);
+		for (Index index = 0; index < slotCount; ++index)
+			slots[index].store(nullptr, std::memory_order_relaxed);
+		retired.clear();
+	}
+
+	std::shared_ptr<TileEntity> TileEntitySlots::get(Index index) const {
+		if (index < 0 || slotCount <= index)
+			return {};
+		Pin pin;
+		if (TileEntity *tile_entity = slots[index].load(std::memory_order_seq_cst))
+			return tile_entity->shared_from_this();
+		return {};
+	}
+
+	void TileEntitySlots::set(Index index, const std::shared_ptr<TileEntity> &tile_entity) {
+		if (0 <= index && index < slotCount)
+			slots[index].store(tile_entity.get(), std::memory_order_release);
+	}
+
+	void TileEntitySlots::erase(Index index, std::shared_ptr<TileEntity> tile_entity) {
+		if (index < 0 || slotCount <= index)
+			return;
+		slots[index].store(nullptr, std::memory_order_seq_cst);
+		// Any reader that pins a later epoch than this one started after the slot was emptied and can't find the tile entity.
+		retired.push_back({globalEpoch.load(std::memory_order_seq_cst), std::move(tile_entity)});
+	}
+
+	void TileEntitySlots::reclaim() {
+		if (retired.empty())
+			return;
+
+		uint64_t oldest_pinned = IDLE;
+		{
+			std::unique_lock lock(readersMutex);
+			for (const ReaderRecord *reader: readers)
+				oldest_pinned = std::min(oldest_pinned, reader->epoch.load(std::memory_order_seq_cst));
+		}
+
+		// A tile entity retired in epoch E can still be being loaded by a reader that pinned E or earlier.
+		auto iter = std::find_if(retired.begin(), retired.end(), [oldest_pinned](const Retired &entry) {
+			return oldest_pinned <= entry.epoch;
+		});
+		retired.erase(retired.begin(), iter);
+	}
+
+	void TileEntitySlots::advanceGlobalEpoch() {
+		globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+	}
+}
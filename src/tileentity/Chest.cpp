@@ -26,7 +26,7 @@ namespace Game3 {
 	}
 
 	bool Chest::onInteractNextTo(const std::shared_ptr<Player> &player) {
-		auto &tab = *getRealm()->getGame().canvas.window.inventoryTab;
+		auto &tab = *getRealm()->getGame().canvas->window.inventoryTab;
 		player->queueForMove([player, &tab](const auto &) {
 			tab.resetExternalInventory();
 			return true;
@@ -22,13 +22,13 @@ namespace Game3 {
 
 	bool CraftingStation::onInteractNextTo(const std::shared_ptr<Player> &player) {
 		player->stationTypes.insert(stationType);
-		auto &tab = *getRealm()->getGame().canvas.window.craftingTab;
+		auto &tab = *getRealm()->getGame().canvas->window.craftingTab;
 		tab.reset(player->getRealm()->getGame().shared_from_this());
 		tab.show();
 		player->queueForMove([player, station_type = stationType, &tab](const auto &) {
 			player->stationTypes.erase(station_type);
 			tab.reset(player->getRealm()->getGame().shared_from_this());
-			player->getRealm()->getGame().canvas.window.inventoryTab->show();
+			player->getRealm()->getGame().canvas->window.inventoryTab->show();
 			return true;
 		});
 		return true;
@@ -130,7 +130,7 @@ namespace Game3 {
 
 		auto realm = getRealm();
 		TileID march_result;
-		const auto &tiles = realm->tilemap2->getTiles();
+		const auto &tilemap = *realm->tilemap2;
 
 		auto check = [&](const Position &offset_position) -> std::optional<bool> {
 			if (!realm->isValid(offset_position))
@@ -149,7 +149,7 @@ namespace Game3 {
 			const Position offset_position(position + Position(row_offset, column_offset));
 			if (auto value = check(offset_position))
 				return *value;
-			return fn(tileset[tiles.at(realm->getIndex(offset_position))], Place(offset_position, realm, nullptr));
+			return fn(tileset[tilemap[offset_position]], Place(offset_position, realm, nullptr));
 		});
 
 		const TileID marched_row = march_result / 7;
@@ -205,8 +205,6 @@ namespace Game3 {
 				default:
 					throw std::invalid_argument("Invalid layer for Ghost: " + std::to_string(details.layer));
 			}
-
-			realm->reupload();
 		}
 	}
 }
@@ -1,3 +1,5 @@
+#include <cmath>
+
 #include "ThreadContext.h"
 #include "Tileset.h"
 #include "entity/ItemEntity.h"
@@ -31,17 +33,34 @@ namespace Game3 {
 			spawnables.push_back(ItemStack::fromJSON(game, spawnable));
 	}
 
-	void ItemSpawner::tick(Game &, float delta) {
-		static std::uniform_real_distribution distribution(0., 1.);
-		for (float i = 0.f; i < delta; i += .1f) {
-			if (distribution(threadContext.rng) < chancePerTenth) {
-				for (const auto &entity: getRealm()->findEntities(getPosition()))
-					if (entity->is("base:entity/item"))
-						return;
-				choose(spawnables).spawn(getRealm(), getPosition());
-				return;
-			}
+	void ItemSpawner::tick(Game &, float) {
+		auto realm = getRealm();
+		const double now = realm->simulatedTime;
+
+		if (0. <= nextAttempt && nextAttempt <= now) {
+			bool occupied = false;
+			for (const auto &entity: realm->findEntities(getPosition()))
+				if (entity->is("base:entity/item"_id)) {
+					occupied = true;
+					break;
+				}
+			if (!occupied)
+				choose(spawnables).spawn(realm, getPosition());
 		}
+
+		if (nextAttempt < 0. || nextAttempt <= now)
+			nextAttempt = now + sampleDelay();
+
+		sleepUntil(nextAttempt);
+	}
+
+	double ItemSpawner::sampleDelay() const {
+		if (chancePerTenth <= 0.f)
+			return INFINITY;
+		if (1.f <= chancePerTenth)
+			return .1;
+		std::exponential_distribution distribution(-std::log1p(-double(chancePerTenth)) / .1);
+		return distribution(threadContext.rng);
 	}
 
 	void ItemSpawner::render(SpriteRenderer &) {}
@@ -42,8 +42,8 @@ namespace Game3 {
 	void OreDeposit::toJSON(nlohmann::json &json) const {
 		TileEntity::toJSON(json);
 		json["oreType"] = oreType;
-		if (0.f < timeRemaining)
-			json["timeRemaining"] = timeRemaining;
+		if (const float time_remaining = getTimeRemaining(); 0.f < time_remaining)
+			json["timeRemaining"] = time_remaining;
 		if (uses != 0)
 			json["uses"] = uses;
 	}
@@ -56,15 +56,11 @@ namespace Game3 {
 		uses = json.contains("uses")? json.at("uses").get<uint32_t>() : 0;
 	}
 
-	void OreDeposit::tick(Game &, float delta) {
-		timeRemaining = std::max(timeRemaining - delta, 0.f);
-	}
-
 	bool OreDeposit::onInteractNextTo(const PlayerPtr &player) {
 		auto &inventory = *player->inventory;
 		const Slot active_slot = inventory.activeSlot;
 		if (auto *active_stack = inventory[active_slot]) {
-			if (0.f < timeRemaining || 0.f < player->tooldown)
+			if (0.f < getTimeRemaining() || 0.f < player->tooldown)
 				return true;
 			if (active_stack->hasAttribute("base:attribute/pickaxe"_id)) {
 				const auto &tool = dynamic_cast<Tool &>(*active_stack->item);
@@ -75,6 +71,7 @@ namespace Game3 {
 
 					if (ore.maxUses <= ++uses) {
 						timeRemaining = ore.cooldown;
+						markUpdated();
 						uses = 0;
 					}
 
@@ -99,7 +96,7 @@ namespace Game3 {
 		if (tileID != tilemap.tileset->getEmpty()) {
 			const Ore &ore = getOre(realm.getGame());
 			const auto tilesize = tilemap.tileSize;
-			const TileID tile_id = (*tilemap.tileset)[0.f < timeRemaining? ore.regenTilename : tileID];
+			const TileID tile_id = (*tilemap.tileset)[0.f < getTimeRemaining()? ore.regenTilename : tileID];
 			const auto x = (tile_id % (tilemap.setWidth / tilesize)) * tilesize;
 			const auto y = (tile_id / (tilemap.setWidth / tilesize)) * tilesize;
 			sprite_renderer(*tilemap.getTexture(realm.getGame()), {
@@ -116,4 +113,8 @@ namespace Game3 {
 	const Ore & OreDeposit::getOre(const Game &game) const {
 		return *game.registry<OreRegistry>().at(oreType);
 	}
+
+	float OreDeposit::getTimeRemaining() const {
+		return std::max<float>(timeRemaining - getTimeSinceUpdate(), 0.f);
+	}
 }
@@ -23,7 +23,7 @@ namespace Game3 {
 	bool Sign::onInteractNextTo(const std::shared_ptr<Player> &player) {
 		getRealm()->getGame().setText(text, name, true, true);
 		player->queueForMove([player](const auto &) {
-			player->getRealm()->getGame().canvas.window.textTab->hide();
+			player->getRealm()->getGame().canvas->window.textTab->hide();
 			return true;
 		});
 		return true;
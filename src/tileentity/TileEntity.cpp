@@ -1,3 +1,5 @@
+#include <cmath>
+
 #include "game/Game.h"
 #include "realm/Realm.h"
 #include "tileentity/TileEntity.h"
@@ -29,8 +31,40 @@ namespace Game3 {
 		getRealm()->updateNeighbors(position);
 	}
 
+	void TileEntity::sleepUntil(double realm_time) {
+		wakeTime = realm_time;
+	}
+
+	void TileEntity::sleepFor(double seconds) {
+		wakeTime = getRealm()->simulatedTime + seconds;
+	}
+
+	void TileEntity::sleepForever() {
+		wakeTime = INFINITY;
+	}
+
+	void TileEntity::wakeUp() {
+		wakeTime = 0.;
+		if (auto realm = weakRealm.lock())
+			realm->wakeTileEntity(shared_from_this());
+	}
+
+	void TileEntity::markUpdated() {
+		lastUpdate.store(getRealm()->simulatedTime.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+
+	double TileEntity::getTimeSinceUpdate() const {
+		// Both times are atomic because tile entities can be read from other realms' threads.
+		const double last_update = lastUpdate.load(std::memory_order_relaxed);
+		if (last_update < 0.)
+			return 0.;
+		if (auto realm = weakRealm.lock())
+			return realm->simulatedTime.load(std::memory_order_relaxed) - last_update;
+		return 0.;
+	}
+
 	bool TileEntity::isVisible() const {
-		return getRealm()->getGame().canvas.inBounds(getPosition());
+		return getRealm()->getGame().canvas->inBounds(getPosition());
 	}
 
 	void TileEntity::absorbJSON(Game &, const nlohmann::json &json) {
@@ -20,8 +20,8 @@ namespace Game3 {
 	void Tree::toJSON(nlohmann::json &json) const {
 		TileEntity::toJSON(json);
 		json["immatureTilename"] = immatureTilename;
-		json["age"] = age;
-		json["hiveAge"] = hiveAge;
+		json["age"] = getAge();
+		json["hiveAge"] = getHiveAge();
 	}
 
 	void Tree::absorbJSON(Game &game, const nlohmann::json &json) {
@@ -41,13 +41,9 @@ namespace Game3 {
 			hiveAge = 0.f;
 	}
 
-	void Tree::tick(Game &, float delta) {
-		age += delta;
-		if (0.f <= hiveAge && hiveAge < HIVE_MATURITY)
-			hiveAge += delta;
-	}
-
 	bool Tree::onInteractNextTo(const std::shared_ptr<Player> &player) {
+		catchUp();
+
 		if (age < MATURITY)
 			return false;
 
@@ -86,6 +82,22 @@ namespace Game3 {
 		return 0.f <= hiveAge;
 	}
 
+	float Tree::getAge() const {
+		return age + getTimeSinceUpdate();
+	}
+
+	float Tree::getHiveAge() const {
+		if (hiveAge < 0.f || HIVE_MATURITY <= hiveAge)
+			return hiveAge;
+		return std::min<float>(hiveAge + getTimeSinceUpdate(), HIVE_MATURITY);
+	}
+
+	void Tree::catchUp() {
+		age = getAge();
+		hiveAge = getHiveAge();
+		markUpdated();
+	}
+
 	bool Tree::kill() {
 		auto &realm = *getRealm();
 
@@ -112,11 +124,12 @@ namespace Game3 {
 		if (tileID != tileset.getEmpty()) {
 			auto &tilemap = *realm->tilemap2;
 			const auto tilesize = tilemap.tileSize;
-			TileID tile_id = tileset[age < MATURITY? immatureTilename : tileID];
+			const float hive_age = getHiveAge();
+			TileID tile_id = tileset[getAge() < MATURITY? immatureTilename : tileID];
 			if (tile_id != getImmatureTileID(tileset)) {
-				if (0.f <= hiveAge)
+				if (0.f <= hive_age)
 					tile_id += 4;
-				if (HIVE_MATURITY <= hiveAge)
+				if (HIVE_MATURITY <= hive_age)
 					tile_id += 3;
 			}
 			const auto x = (tile_id % (tilemap.setWidth / tilesize)) * tilesize;
@@ -17,8 +17,8 @@
 #include "util/Util.h"
 
 namespace Game3 {
-	ElementBufferedRenderer::ElementBufferedRenderer(Realm &realm_):
-		reshader(blur_frag), realm(realm_) {}
+	ElementBufferedRenderer::ElementBufferedRenderer(Realm &realm_, uint8_t layer_):
+		reshader(blur_frag), realm(realm_), layer(layer_) {}
 
 	ElementBufferedRenderer::~ElementBufferedRenderer() {
 		reset();
@@ -36,6 +36,7 @@ namespace Game3 {
 			tilemap.reset();
 			rectangle.reset();
 			fbo.reset();
+			journalCursor.reset();
 			initialized = false;
 		}
 	}
@@ -54,6 +55,7 @@ namespace Game3 {
 		brightTiles.assign(bright_shorts.begin(), bright_shorts.end());
 		brightTiles.resize(8, -1);
 		brightSet = {bright_shorts.begin(), bright_shorts.end()};
+		journalCursor = realm.journal.subscribe();
 		initialized = true;
 	}
 
@@ -61,6 +63,8 @@ namespace Game3 {
 		if (!initialized)
 			return;
 
+		applyJournal();
+
 		if (dirty) {
 			recomputeLighting();
 			dirty = false;
@@ -89,6 +93,8 @@ namespace Game3 {
 		if (!initialized)
 			return;
 
+		applyJournal();
+
 		if (dirty) {
 			recomputeLighting();
 			dirty = false;
@@ -112,8 +118,14 @@ namespace Game3 {
 	}
 
 	void ElementBufferedRenderer::reupload() {
+		if (!initialized)
+			return;
 		generateVertexBufferObject();
 		generateVertexArrayObject();
+		// Everything journaled so far is in the new buffer already.
+		if (journalCursor)
+			realm.journal.read(*journalCursor, [](const RealmJournal::Entry &) {});
+		dirty = true;
 	}
 
 	bool ElementBufferedRenderer::onBackbufferResized(int width, int height) {
@@ -125,22 +137,60 @@ namespace Game3 {
 	}
 
 	void ElementBufferedRenderer::generateVertexBufferObject() {
+		vbo.init<float, 3>(tilemap->width, tilemap->height, GL_STATIC_DRAW, [this](size_t x, size_t y) {
+			return generateTile(x, y);
+		});
+	}
+
+	std::array<std::array<float, 3>, 4> ElementBufferedRenderer::generateTile(size_t x, size_t y) const {
 		const auto set_width = tilemap->setWidth / tilemap->tileSize;
 		const float divisor = set_width;
 		const float t_size = 1.f / divisor - TILE_TEXTURE_PADDING * 2;
+		const auto tile = (*tilemap)(x, y);
+		const float tx0 = (tile % set_width) / divisor + TILE_TEXTURE_PADDING;
+		const float ty0 = (tile / set_width) / divisor + TILE_TEXTURE_PADDING;
+		const float tile_f = static_cast<float>(tile);
+		return std::array {
+			std::array {tx0,          ty0,          tile_f},
+			std::array {tx0 + t_size, ty0,          tile_f},
+			std::array {tx0,          ty0 + t_size, tile_f},
+			std::array {tx0 + t_size, ty0 + t_size, tile_f},
+		};
+	}
+
+	void ElementBufferedRenderer::applyJournal() {
+		if (!journalCursor)
+			return;
 
-		vbo.init<float, 3>(tilemap->width, tilemap->height, GL_STATIC_DRAW, [this, set_width, divisor, t_size](size_t x, size_t y) {
-			const auto tile = (*tilemap)(x, y);
-			const float tx0 = (tile % set_width) / divisor + TILE_TEXTURE_PADDING;
-			const float ty0 = (tile / set_width) / divisor + TILE_TEXTURE_PADDING;
-			const float tile_f = static_cast<float>(tile);
-			return std::array {
-				std::array {tx0,          ty0,          tile_f},
-				std::array {tx0 + t_size, ty0,          tile_f},
-				std::array {tx0,          ty0 + t_size, tile_f},
-				std::array {tx0 + t_size, ty0 + t_size, tile_f},
-			};
+		std::vector<TileRect> rects;
+		const bool complete = realm.journal.read(*journalCursor, [&](const RealmJournal::Entry &entry) {
+			const auto &dirty_tiles = entry.dirtyTiles[layer - 1];
+			rects.insert(rects.end(), dirty_tiles.begin(), dirty_tiles.end());
 		});
+
+		if (!complete) {
+			reupload();
+			return;
+		}
+
+		if (rects.empty())
+			return;
+
+		// Each square is 4 vertices of 2 position floats and 3 generated floats. A column of a rectangle is contiguous
+		// in the buffer, so each one is a single upload.
+		constexpr size_t floats_per_square = 4 * (2 + 3);
+		const size_t height = tilemap->height;
+		std::vector<float> vertex_data;
+		for (const TileRect &rect: rects) {
+			for (Index x = rect.column; x < rect.column + rect.width; ++x) {
+				vertex_data.clear();
+				for (Index y = rect.row; y < rect.row + rect.height; ++y)
+					GL::pushSquare<float, 3>(vertex_data, x, y, generateTile(x, y));
+				vbo.update((static_cast<size_t>(x) * height + rect.row) * floats_per_square, vertex_data.data(), vertex_data.size());
+			}
+		}
+
+		dirty = true;
 	}
 
 	void ElementBufferedRenderer::generateElementBufferObject() {
@@ -1,5 +1,4 @@
 #include <deque>
-#include <fstream>
 #include <iostream>
 
 #include "Shader.h"
@@ -11,6 +10,7 @@
 #include "game/Game.h"
 #include "game/HasInventory.h"
 #include "game/Inventory.h"
+#include "game/SaveFile.h"
 #include "tileentity/Building.h"
 #include "tileentity/Teleporter.h"
 #include "ui/gtk/CommandDialog.h"
@@ -24,11 +24,8 @@
 #include "util/FS.h"
 #include "util/Timer.h"
 #include "util/Util.h"
-#include "worldgen/Overworld.h"
 #include "worldgen/WorldGen.h"
 
-// #define USE_CBOR
-
 namespace Game3 {
 	static std::chrono::milliseconds arrowTime {100};
 	static std::chrono::milliseconds interactTime {500};
@@ -284,22 +281,7 @@ namespace Game3 {
 		Timer timer("NewGame");
 		glArea.get_context()->make_current();
 		game = Game::create(*canvas);
-		game->initEntities();
-		auto tileset = game->registry<TilesetRegistry>().at("base:tileset/monomap"_id);
-		auto tileset_texture = tileset->getTexture(*game);
-		auto tilemap = std::make_shared<Tilemap>(width, height, 16, *tileset_texture->width, *tileset_texture->height, tileset);
-		tilemap->init(*game);
-		auto biomemap = std::make_shared<BiomeMap>(width, height);
-		auto realm = Realm::create(*game, 1, "base:realm/overworld"_id, tilemap, biomemap, seed);
-		realm->outdoors = true;
-		std::default_random_engine rng;
-		rng.seed(seed);
-		WorldGen::generateOverworld(realm, seed, params);
-		game->realms.emplace(realm->id, realm);
-		game->activeRealm = realm;
-		realm->add(game->player = Entity::create<Player>());
-		game->player->position = {realm->randomLand / width, realm->randomLand % width};
-		game->player->init(*game);
+		game->generateWorld(seed, width, height, params);
 		onGameLoaded();
 		game->player->inventory->add(ItemStack::withDurability(*game, "base:item/iron_pickaxe"));
 		game->player->inventory->add(ItemStack::withDurability(*game, "base:item/iron_shovel"));
@@ -313,25 +295,17 @@ namespace Game3 {
 
 	void MainWindow::loadGame(const std::filesystem::path &path) {
 		glArea.get_context()->make_current();
-		const std::string data = readFile(path);
-		if (!data.empty() && data.front() == '{')
-			game = Game::fromJSON(nlohmann::json::parse(data), *canvas);
-		else
-			game = Game::fromJSON(nlohmann::json::from_cbor(data), *canvas);
-		game->initEntities();
-		for (auto &[id, realm]: game->realms)
-			realm->remakePathMap();
-		for (const auto &entity: game->activeRealm->entities)
-			if (entity->isPlayer()) {
-				if (!(game->player = std::dynamic_pointer_cast<Player>(entity)))
-					throw std::runtime_error("Couldn't cast entity with isPlayer() == true to Player");
-				break;
-			}
-		if (!game->player)
-			throw std::runtime_error("Player not found in active realm");
-		for (const auto &[id, realm]: game->realms)
-			for (const auto &entity: realm->entities)
-				entity->initAfterLoad(*game);
+		if (isSaveContainer(path)) {
+			auto mapping = std::make_shared<MappedFile>(path);
+			game = Game::fromJSON(readSave(*mapping), *canvas, mapping);
+		} else {
+			const std::string data = readFile(path);
+			if (!data.empty() && data.front() == '{')
+				game = Game::fromJSON(nlohmann::json::parse(data), *canvas);
+			else
+				game = Game::fromJSON(nlohmann::json::from_cbor(data), *canvas);
+		}
+		game->initAfterLoad();
 		onGameLoaded();
 	}
 
@@ -369,20 +343,13 @@ namespace Game3 {
 	}
 
 	void MainWindow::saveGame(const std::filesystem::path &path) {
-		std::ofstream stream(path);
-
-		if (!stream.is_open()) {
-			error("Couldn't open file for writing.");
-			return;
-		}
+		saveGame(path, Tilemap::DEFAULT_COMPRESSION_LEVEL);
+	}
 
-#ifdef USE_CBOR
-		auto cbor = nlohmann::json::to_cbor(nlohmann::json(*game));
-		stream.write(reinterpret_cast<char *>(&cbor[0]), cbor.size());
-#else
-		stream << nlohmann::json(*game).dump();
-#endif
-		stream.close();
+	void MainWindow::saveGame(const std::filesystem::path &path, int compression_level) {
+		nlohmann::json json;
+		game->toJSON(json, compression_level);
+		writeSave(path, std::move(json));
 	}
 
 	bool MainWindow::render(const Glib::RefPtr<Gdk::GLContext> &context) {
@@ -636,28 +603,28 @@ namespace Game3 {
 			switch (keyval) {
 				case GDK_KEY_S:
 				case GDK_KEY_s:
-					player.path.clear();
+					player.clearPath();
 					if (!player.isMoving())
 						player.continuousInteraction = keyval == GDK_KEY_S;
 					player.movingDown = true;
 					return;
 				case GDK_KEY_W:
 				case GDK_KEY_w:
-					player.path.clear();
+					player.clearPath();
 					if (!player.isMoving())
 						player.continuousInteraction = keyval == GDK_KEY_W;
 					player.movingUp = true;
 					return;
 				case GDK_KEY_A:
 				case GDK_KEY_a:
-					player.path.clear();
+					player.clearPath();
 					if (!player.isMoving())
 						player.continuousInteraction = keyval == GDK_KEY_A;
 					player.movingLeft = true;
 					return;
 				case GDK_KEY_D:
 				case GDK_KEY_d:
-					player.path.clear();
+					player.clearPath();
 					if (!player.isMoving())
 						player.continuousInteraction = keyval == GDK_KEY_D;
 					player.movingRight = true;
@@ -35,29 +35,19 @@ namespace Game3 {
 	static inline void getNeighbors(const std::shared_ptr<Realm> &realm, const Position &position, std::vector<Position> &next) {
 		next.clear();
 
-		if (0 < position.row) {
-			const Position next_pos(position.row - 1, position.column);
-			if (realm->pathMap[realm->getIndex(next_pos)] != 0)
-				next.emplace_back(next_pos);
-		}
+		const uint8_t neighbors = realm->pathMap.getNeighbors(position);
 
-		if (0 < position.column) {
-			const Position next_pos(position.row, position.column - 1);
-			if (realm->pathMap[realm->getIndex(next_pos)] != 0)
-				next.emplace_back(next_pos);
-		}
+		if (neighbors & PathMap::UP)
+			next.emplace_back(position.row - 1, position.column);
 
-		if (position.row < realm->getHeight() - 1) {
-			const Position next_pos(position.row + 1, position.column);
-			if (realm->pathMap[realm->getIndex(next_pos)] != 0)
-				next.emplace_back(next_pos);
-		}
+		if (neighbors & PathMap::LEFT)
+			next.emplace_back(position.row, position.column - 1);
 
-		if (position.column < realm->getWidth() - 1) {
-			const Position next_pos(position.row, position.column + 1);
-			if (realm->pathMap[realm->getIndex(next_pos)] != 0)
-				next.emplace_back(next_pos);
-		}
+		if (neighbors & PathMap::DOWN)
+			next.emplace_back(position.row + 1, position.column);
+
+		if (neighbors & PathMap::RIGHT)
+			next.emplace_back(position.row, position.column + 1);
 	}
 
 	// Credit: https://www.redblobgames.com/pathfinding/a-star/implementation.html#cplusplus
@@ -1,4 +1,11 @@
+#include <cstring>
 #include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "util/FS.h"
 
@@ -18,4 +25,36 @@ namespace Game3 {
 		stream.close();
 		return out;
 	}
+
+	MappedFile::MappedFile(const std::filesystem::path &path) {
+		const int fd = open(path.c_str(), O_RDONLY);
+		if (fd == -1)
+			throw std::runtime_error("Couldn't open file for mapping: " + std::string(std::strerror(errno)));
+
+		struct stat info;
+		if (fstat(fd, &info) == -1) {
+			const int error = errno;
+			close(fd);
+			throw std::runtime_error("Couldn't stat file for mapping: " + std::string(std::strerror(error)));
+		}
+
+		length = static_cast<size_t>(info.st_size);
+
+		if (length != 0) {
+			void *mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			if (mapping == MAP_FAILED) {
+				const int error = errno;
+				close(fd);
+				throw std::runtime_error("Couldn't map file: " + std::string(std::strerror(error)));
+			}
+			bytes = static_cast<uint8_t *>(mapping);
+		}
+
+		close(fd);
+	}
+
+	MappedFile::~MappedFile() {
+		if (bytes)
+			munmap(bytes, length);
+	}
 }
@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+#include "ThreadContext.h"
+#include "util/ObjectPool.h"
+
+namespace Game3 {
+	namespace {
+		std::atomic<uint64_t> nextPoolID = 1;
+	}
+
+	/** The free blocks a thread holds on to for the pool it last allocated from. */
+	struct ThreadCache {
+		struct List {
+			ObjectPool::FreeBlock *head = nullptr;
+			size_t count = 0;
+		};
+
+		/** 0 if the cache isn't bound to a pool. */
+		uint64_t poolID = 0;
+		/** Weak so that a cache doesn't keep a pool alive. If the pool is gone by the time the cache is flushed, so is
+		 *  the memory the cached blocks point into, and they're simply forgotten. */
+		std::weak_ptr<ObjectPool> pool;
+		std::array<List, ObjectPool::SIZE_CLASS_COUNT> lists;
+
+		~ThreadCache() {
+			flush();
+		}
+
+		void bind(ObjectPool &new_pool) {
+			flush();
+			poolID = new_pool.id;
+			pool = new_pool.weak_from_this();
+		}
+
+		void flush() {
+			if (auto locked = pool.lock())
+				for (List &list: lists)
+					if (list.head != nullptr)
+						locked->returnBlocks(list.head);
+			lists = {};
+			poolID = 0;
+			pool.reset();
+		}
+	};
+
+	namespace {
+		thread_local ThreadCache threadCache;
+	}
+
+	ObjectPool::Scope::Scope(std::shared_ptr<ObjectPool> pool_):
+	pool(std::move(pool_)), previous(threadContext.objectPool) {
+		threadContext.objectPool = pool.get();
+	}
+
+	ObjectPool::Scope::~Scope() {
+		threadContext.objectPool = previous;
+	}
+
+	ObjectPool::ObjectPool(): id(nextPoolID++) {}
+
+	ObjectPool::~ObjectPool() {
+		// Blocks still in thread caches point into these slabs, but those caches can no longer lock this pool and will
+		// drop them without touching them.
+		while (slabs != nullptr) {
+			Slab *next = slabs->next;
+			::operator delete(slabs, std::align_val_t(SLAB_SIZE));
+			slabs = next;
+		}
+	}
+
+	void * ObjectPool::allocate(size_t size, size_t alignment) {
+		if (!isPooled(size, alignment))
+			return ::operator new(size, std::align_val_t(alignment));
+
+		const size_t size_class = getSizeClass(size);
+		ThreadCache &cache = threadCache;
+		if (cache.poolID != id)
+			cache.bind(*this);
+
+		ThreadCache::List &list = cache.lists[size_class];
+		if (list.head == nullptr)
+			list.count = takeBlocks(size_class, list.head, CACHE_BATCH);
+
+		FreeBlock *block = list.head;
+		list.head = block->next;
+		--list.count;
+		return block;
+	}
+
+	void ObjectPool::deallocate(void *pointer, size_t size, size_t alignment) noexcept {
+		if (pointer == nullptr)
+			return;
+
+		if (!isPooled(size, alignment)) {
+			::operator delete(pointer, std::align_val_t(alignment));
+			return;
+		}
+
+		FreeBlock *block = new (pointer) FreeBlock{nullptr};
+		ThreadCache &cache = threadCache;
+		if (cache.poolID != id) {
+			// The cache belongs to another pool. Rebinding it here would make threads that free objects from many pools
+			// flush their caches constantly.
+			std::unique_lock lock(mutex);
+			returnBlock(block);
+			return;
+		}
+
+		ThreadCache::List &list = cache.lists[getSizeClass(size)];
+		block->next = list.head;
+		list.head = block;
+
+		if (++list.count < 2 * CACHE_BATCH)
+			return;
+
+		// Give the older half back. The newest blocks stay in the cache because they're the likeliest to be in the CPU cache.
+		FreeBlock *last_kept = list.head;
+		for (size_t i = 1; i < CACHE_BATCH; ++i)
+			last_kept = last_kept->next;
+		FreeBlock *returned = last_kept->next;
+		last_kept->next = nullptr;
+		list.count = CACHE_BATCH;
+		returnBlocks(returned);
+	}
+
+	size_t ObjectPool::takeBlocks(size_t size_class, FreeBlock *&list, size_t count) {
+		const size_t block_size = (size_class + 1) * GRANULARITY;
+		std::unique_lock lock(mutex);
+		auto &sizes = sizeClasses[size_class];
+		size_t taken = 0;
+
+		while (taken < count) {
+			Slab *slab = sizes.partial;
+			if (slab == nullptr) {
+				slab = makeSlab(size_class);
+				addPartial(slab);
+			}
+
+			std::byte *const end = reinterpret_cast<std::byte *>(slab) + SLAB_SIZE;
+			while (taken < count) {
+				FreeBlock *block = slab->freeList;
+				if (block != nullptr) {
+					slab->freeList = block->next;
+				} else if (block_size <= static_cast<size_t>(end - slab->unused)) {
+					block = reinterpret_cast<FreeBlock *>(slab->unused);
+					slab->unused += block_size;
+				} else {
+					break;
+				}
+				block->next = list;
+				list = block;
+				++slab->used;
+				++taken;
+			}
+
+			if (slab->freeList == nullptr && static_cast<size_t>(end - slab->unused) < block_size)
+				removePartial(slab);
+		}
+
+		return taken;
+	}
+
+	void ObjectPool::returnBlocks(FreeBlock *list) {
+		std::unique_lock lock(mutex);
+		while (list != nullptr) {
+			FreeBlock *next = list->next;
+			returnBlock(list);
+			list = next;
+		}
+	}
+
+	void ObjectPool::returnBlock(FreeBlock *block) {
+		Slab *slab = getSlab(block);
+		block->next = slab->freeList;
+		slab->freeList = block;
+		if (!slab->partial)
+			addPartial(slab);
+		// The last slab of a size class is kept so that a size class that keeps emptying and refilling one slab doesn't
+		// allocate and free it over and over.
+		if (--slab->used == 0 && 1 < sizeClasses[slab->sizeClass].slabCount)
+			releaseSlab(slab);
+	}
+
+	ObjectPool::Slab * ObjectPool::makeSlab(size_t size_class) {
+		void *memory = ::operator new(SLAB_SIZE, std::align_val_t(SLAB_SIZE));
+		Slab *slab = new (memory) Slab;
+		slab->unused = static_cast<std::byte *>(memory) + SLAB_HEADER_SIZE;
+		slab->sizeClass = size_class;
+		slab->next = slabs;
+		if (slabs != nullptr)
+			slabs->previous = slab;
+		slabs = slab;
+		++sizeClasses[size_class].slabCount;
+		return slab;
+	}
+
+	void ObjectPool::releaseSlab(Slab *slab) {
+		if (slab->partial)
+			removePartial(slab);
+		if (slab->previous != nullptr)
+			slab->previous->next = slab->next;
+		else
+			slabs = slab->next;
+		if (slab->next != nullptr)
+			slab->next->previous = slab->previous;
+		--sizeClasses[slab->sizeClass].slabCount;
+		::operator delete(slab, std::align_val_t(SLAB_SIZE));
+	}
+
+	void ObjectPool::addPartial(Slab *slab) {
+		auto &sizes = sizeClasses[slab->sizeClass];
+		slab->previousPartial = nullptr;
+		slab->nextPartial = sizes.partial;
+		if (sizes.partial != nullptr)
+			sizes.partial->previousPartial = slab;
+		sizes.partial = slab;
+		slab->partial = true;
+	}
+
+	void ObjectPool::removePartial(Slab *slab) {
+		if (slab->previousPartial != nullptr)
+			slab->previousPartial->nextPartial = slab->nextPartial;
+		else
+			sizeClasses[slab->sizeClass].partial = slab->nextPartial;
+		if (slab->nextPartial != nullptr)
+			slab->nextPartial->previousPartial = slab->previousPartial;
+		slab->previousPartial = slab->nextPartial = nullptr;
+		slab->partial = false;
+	}
+
+	void ObjectPool::pin() {
+		if (pinCount.fetch_add(1, std::memory_order_acq_rel) != 0)
+			return;
+		std::unique_lock lock(mutex);
+		// An unpin on another thread may have seen the count drop to zero in between. Whichever of the two takes the
+		// lock last sees the final count.
+		if (pinCount.load(std::memory_order_acquire) != 0 && !self)
+			self = shared_from_this();
+	}
+
+	void ObjectPool::unpin() noexcept {
+		if (pinCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+		// Released after the lock, since it may be the last reference.
+		std::shared_ptr<ObjectPool> released;
+		{
+			std::unique_lock lock(mutex);
+			if (pinCount.load(std::memory_order_acquire) == 0)
+				released = std::move(self);
+		}
+	}
+
+	const std::shared_ptr<ObjectPool> & ObjectPool::getDefault() {
+		static const auto pool = std::make_shared<ObjectPool>();
+		return pool;
+	}
+
+	ObjectPool & ObjectPool::getCurrent() {
+		if (threadContext.objectPool != nullptr)
+			return *threadContext.objectPool;
+		return *getDefault();
+	}
+}
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <utility>
+
+#include "util/ThreadPool.h"
+
+namespace Game3 {
+	ThreadPool::ThreadPool(size_t thread_count) {
+		if (thread_count == 0)
+			thread_count = std::max(1u, std::thread::hardware_concurrency());
+		workers.reserve(thread_count - 1);
+		for (size_t i = 1; i < thread_count; ++i)
+			workers.emplace_back([this] { work(); });
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::unique_lock lock(mutex);
+			stopping = true;
+		}
+		workReady.notify_all();
+		for (auto &worker: workers)
+			worker.join();
+	}
+
+	void ThreadPool::run(size_t count, const std::function<void(size_t)> &function) {
+		if (count == 0)
+			return;
+
+		if (workers.empty() || count == 1) {
+			for (size_t index = 0; index < count; ++index)
+				function(index);
+			return;
+		}
+
+		{
+			std::unique_lock lock(mutex);
+			job = &function;
+			jobCount = count;
+			next = 0;
+			error = nullptr;
+			busyWorkers = workers.size();
+			++generation;
+		}
+
+		workReady.notify_all();
+		drain(function, count);
+
+		std::unique_lock lock(mutex);
+		workDone.wait(lock, [this] { return busyWorkers == 0; });
+		job = nullptr;
+
+		if (error)
+			std::rethrow_exception(std::exchange(error, nullptr));
+	}
+
+	void ThreadPool::work() {
+		size_t seen_generation = 0;
+
+		for (;;) {
+			const std::function<void(size_t)> *function = nullptr;
+			size_t count = 0;
+
+			{
+				std::unique_lock lock(mutex);
+				workReady.wait(lock, [&] { return stopping || seen_generation != generation; });
+				if (stopping)
+					return;
+				seen_generation = generation;
+				function = job;
+				count = jobCount;
+			}
+
+			drain(*function, count);
+
+			{
+				std::unique_lock lock(mutex);
+				if (--busyWorkers == 0)
+					workDone.notify_one();
+			}
+		}
+	}
+
+	void ThreadPool::drain(const std::function<void(size_t)> &function, size_t count) {
+		try {
+			for (size_t index; (index = next++) < count;)
+				function(index);
+		} catch (...) {
+			std::unique_lock lock(mutex);
+			if (!error)
+				error = std::current_exception();
+			next = count;
+		}
+	}
+}
@@ -12,6 +12,7 @@
 namespace Game3::WorldGen {
 	void generateCave(const std::shared_ptr<Realm> &realm, std::default_random_engine &rng, int noise_seed, Index exit_index, Position &entrance, RealmID parent_realm) {
 		constexpr double noise_zoom = 20;
+		ObjectPool::Scope pool_scope(realm->objectPool);
 
 		const auto width  = realm->getWidth();
 		const auto height = realm->getHeight();
@@ -28,6 +29,7 @@ namespace Game3::WorldGen {
 		tilemap2->reset();
 		tilemap3->reset();
 
+		Realm::Transaction transaction(*realm);
 		std::vector<Position> inside;
 
 		for (Index row = 0; row < height; ++row)
@@ -15,6 +15,7 @@
 namespace Game3::WorldGen {
 	void generateHouse(const std::shared_ptr<Realm> &realm, std::default_random_engine &rng, const std::shared_ptr<Realm> &parent_realm, const Position &entrance) {
 		Timer timer("GenerateHouse");
+		ObjectPool::Scope pool_scope(realm->objectPool);
 		const auto width  = realm->getWidth();
 		const auto height = realm->getHeight();
 
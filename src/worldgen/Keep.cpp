@@ -10,6 +10,7 @@
 namespace Game3::WorldGen {
 	void generateKeep(const std::shared_ptr<Keep> &realm, std::default_random_engine &rng, RealmID parent_realm, const Position &entrance) {
 		Timer timer("GenerateKeep");
+		ObjectPool::Scope pool_scope(realm->objectPool);
 		const auto width  = realm->getWidth();
 		const auto height = realm->getHeight();
 		for (int column = 1; column < width - 1; ++column) {
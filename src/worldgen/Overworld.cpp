@@ -22,8 +22,10 @@ namespace Game3::WorldGen {
 		const auto width  = realm->getWidth();
 		const auto height = realm->getHeight();
 
-		const size_t regions_x = updiv(static_cast<size_t>(width), params.regionSize);
-		const size_t regions_y = updiv(static_cast<size_t>(height), params.regionSize);
+		// Regions have to consist of whole tilemap chunks so that threads never write to the same chunk.
+		const size_t region_size = updiv(params.regionSize, static_cast<size_t>(TileChunk::SIZE)) * TileChunk::SIZE;
+		const size_t regions_x = updiv(static_cast<size_t>(width), region_size);
+		const size_t regions_y = updiv(static_cast<size_t>(height), region_size);
 		const size_t thread_count = regions_x * regions_y;
 
 		auto &biome_map = realm->biomeMap;
@@ -57,13 +59,13 @@ namespace Game3::WorldGen {
 			for (Index column = 0; column < width; ++column) {
 				const double noise = std::min(1., std::max(-1., p2.GetValue(row / params.biomeZoom, column / params.biomeZoom, 0.0) * 5.));
 				if (noise < -0.8)
-					biome_map->tiles.at(realm->getIndex(row, column)) = Biome::VOLCANIC;
+					(*biome_map)(column, row) = Biome::VOLCANIC;
 				else if (noise < -0.5)
-					biome_map->tiles.at(realm->getIndex(row, column)) = Biome::DESERT;
+					(*biome_map)(column, row) = Biome::DESERT;
 				else if (0.7 < noise)
-					biome_map->tiles.at(realm->getIndex(row, column)) = Biome::SNOWY;
+					(*biome_map)(column, row) = Biome::SNOWY;
 				else
-					biome_map->tiles.at(realm->getIndex(row, column)) = Biome::GRASSLAND;
+					(*biome_map)(column, row) = Biome::GRASSLAND;
 			}
 		}
 
@@ -71,15 +73,15 @@ namespace Game3::WorldGen {
 		perlin.SetSeed(noise_seed);
 
 		for (size_t thread_row = 0; thread_row < regions_y; ++thread_row) {
-			const size_t row_min_long = thread_row * params.regionSize;
-			const size_t row_max_long = std::min(static_cast<size_t>(height), (thread_row + 1) * params.regionSize);
+			const size_t row_min_long = thread_row * region_size;
+			const size_t row_max_long = std::min(static_cast<size_t>(height), (thread_row + 1) * region_size);
 
 			if (INT_MAX < row_min_long)
 				throw std::runtime_error("Not going to generate an impossibly large world");
 
 			for (size_t thread_col = 0; thread_col < regions_x; ++thread_col) {
-				const size_t col_min_long = thread_col * params.regionSize;
-				const size_t col_max_long = std::min(static_cast<size_t>(width), (thread_col + 1) * params.regionSize);
+				const size_t col_min_long = thread_col * region_size;
+				const size_t col_max_long = std::min(static_cast<size_t>(width), (thread_col + 1) * region_size);
 
 				if (INT_MAX < col_min_long)
 					throw std::runtime_error("Not going to generate an impossibly large world");
@@ -91,6 +93,7 @@ namespace Game3::WorldGen {
 
 				threads.emplace_back([&, row_min, row_max, col_min, col_max] {
 					threadContext = {realm->getGame().shared_from_this(), noise_seed - 1'000'000ul * row_min + col_min, row_min, row_max, col_min, col_max};
+					ObjectPool::Scope pool_scope(realm->objectPool);
 
 					// Timer noise_timer("BiomeGeneration");
 					for (auto row = row_min; row < row_max; ++row)
@@ -102,7 +105,7 @@ namespace Game3::WorldGen {
 					std::vector<Index> resource_starts;
 					resource_starts.reserve(width * height / 10);
 
-					const auto ore_set = tileset.getCategoryIDs("base:category/orespawns"_id);
+					const auto &ore_set = tileset.getCategory("base:category/orespawns"_id);
 
 					// for (Index index = width * row_min, max = width * row_max; index < max; ++index)
 					for (auto row = row_min; row < row_max; ++row) {
@@ -146,6 +149,10 @@ namespace Game3::WorldGen {
 
 		threads.clear();
 
+		// Biome generation writes to the tilemap directly, so the cells have to be caught up before they're used to look for land.
+		realm->remakeCells();
+		const bool use_cells = realm->hasCells();
+
 		std::default_random_engine rng(noise_seed);
 
 		constexpr int m = 26, n = 34, pad = 2;
@@ -162,7 +169,6 @@ namespace Game3::WorldGen {
 			std::vector<std::thread> candidate_threads;
 			const size_t chunk_max = updiv(starts.size(), chunk_size);
 			candidate_threads.reserve(chunk_max);
-			const auto &tiles1 = tilemap1->getTiles();
 
 			std::mutex candidates_mutex;
 
@@ -186,7 +192,7 @@ namespace Game3::WorldGen {
 						for (size_t row = row_start; row < row_end; row += 2) {
 							for (size_t column = column_start; column < column_end; column += 2) {
 								const Index index = row * tilemap1->width + column;
-								if (!tileset.isLand(tiles1[index]))
+								if (use_cells? !realm->getCell(index).isLand() : !tileset.isLand((*tilemap1)[index]))
 									goto failed;
 							}
 						}
@@ -211,17 +217,18 @@ namespace Game3::WorldGen {
 		Timer postgen_timer("Postgen");
 
 		for (size_t thread_row = 0; thread_row < regions_y; ++thread_row) {
-			const size_t row_min = thread_row * params.regionSize;
-			const size_t row_max = std::min(static_cast<size_t>(height), (thread_row + 1) * params.regionSize);
+			const size_t row_min = thread_row * region_size;
+			const size_t row_max = std::min(static_cast<size_t>(height), (thread_row + 1) * region_size);
 			for (size_t thread_col = 0; thread_col < regions_y; ++thread_col) {
-				const size_t col_min = thread_col * params.regionSize;
-				const size_t col_max = std::min(static_cast<size_t>(width), (thread_col + 1) * params.regionSize);
+				const size_t col_min = thread_col * region_size;
+				const size_t col_max = std::min(static_cast<size_t>(width), (thread_col + 1) * region_size);
 				const auto col_min_index = static_cast<Index>(col_min);
 				const auto col_max_index = static_cast<Index>(col_max);
 				const auto row_min_index = static_cast<Index>(row_min);
 				const auto row_max_index = static_cast<Index>(row_max);
 				threads.emplace_back([realm, &get_biome, &perlin, &params, noise_seed, row_min_index, row_max_index, col_min_index, col_max_index] {
 					threadContext = {realm->getGame().shared_from_this(), noise_seed - 1'000'000ul * row_min_index + col_min_index, row_min_index, row_max_index, col_min_index, col_max_index};
+					ObjectPool::Scope pool_scope(realm->objectPool);
 					for (Index row = row_min_index; row < row_max_index; ++row)
 						for (Index column = col_min_index; column < col_max_index; ++column)
 							get_biome(row, column).postgen(row, column, threadContext.rng, perlin, params);
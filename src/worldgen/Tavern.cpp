@@ -13,6 +13,7 @@
 namespace Game3::WorldGen {
 	void generateTavern(const std::shared_ptr<Realm> &realm, std::default_random_engine &rng, const std::shared_ptr<Realm> &parent_realm, const Position &entrance) {
 		Timer timer("GenerateTavern");
+		ObjectPool::Scope pool_scope(realm->objectPool);
 		const auto width  = realm->getWidth();
 		const auto height = realm->getHeight();
 
@@ -18,6 +18,8 @@ namespace Game3::WorldGen {
 
 		Game &game = realm->getGame();
 		const auto map_width = realm->getWidth();
+		Realm::Transaction transaction(*realm);
+		ObjectPool::Scope pool_scope(realm->objectPool);
 
 		const auto cleanup = [&](Index row, Index column) {
 			if (auto tile_entity = realm->tileEntityAt({row, column}))